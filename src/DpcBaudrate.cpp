@@ -0,0 +1,65 @@
+// diyPresso Client Baud Rate Support - Platform support: macOS 13+ and Windows 10/11 only
+#include "DpcBaudrate.h"
+
+#if defined(__linux__)
+    #include <asm/termbits.h>
+    #include <sys/ioctl.h>
+#elif defined(__APPLE__)
+    #include <termios.h>
+    #include <sys/ioctl.h>
+    #include <IOKit/serial/ioss.h>
+#endif
+
+bool DpcBaudrate::set_custom(int fd, unsigned int baudrate) {
+#if defined(__linux__)
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) != 0) {
+        return false;
+    }
+    tio.c_cflag &= ~CBAUD;
+    tio.c_cflag |= BOTHER;
+    tio.c_ospeed = baudrate;
+    tio.c_cflag &= ~(CBAUD << IBSHIFT);
+    tio.c_cflag |= BOTHER << IBSHIFT;
+    tio.c_ispeed = baudrate;
+    return ioctl(fd, TCSETS2, &tio) == 0;
+#elif defined(__APPLE__)
+    speed_t speed = baudrate;
+    return ioctl(fd, IOSSIOSPEED, &speed) == 0;
+#else
+    (void)fd;
+    (void)baudrate;
+    return false;
+#endif
+}
+
+bool DpcBaudrate::get_actual(int fd, unsigned int& baudrate) {
+#if defined(__linux__)
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) != 0) {
+        return false;
+    }
+    baudrate = tio.c_ospeed;
+    return true;
+#elif defined(__APPLE__)
+    // speed_t holds the numeric rate on macOS, including IOSSIOSPEED rates
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        return false;
+    }
+    baudrate = static_cast<unsigned int>(cfgetospeed(&tio));
+    return true;
+#else
+    (void)fd;
+    (void)baudrate;
+    return false;
+#endif
+}
+
+bool DpcBaudrate::supports_custom() {
+#if defined(__linux__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,17 @@
+// diyPresso Client Baud Rate Support - Platform support: macOS 13+ and Windows 10/11 only
+#pragma once
+
+// Baud rates that have no POSIX Bxxx constant. Kept in its own translation unit because
+// the Linux termios2 definitions (<asm/termbits.h>) clash with <termios.h>.
+class DpcBaudrate {
+public:
+    // Apply an arbitrary rate to an open, already configured port
+    // (Linux: termios2 with BOTHER, macOS: IOSSIOSPEED). Must follow the last tcsetattr().
+    static bool set_custom(int fd, unsigned int baudrate);
+
+    // Read back the output rate the driver actually uses
+    static bool get_actual(int fd, unsigned int& baudrate);
+
+    // Whether set_custom() is available on this platform
+    static bool supports_custom();
+};
@@ -0,0 +1,181 @@
+#include "DpcBossac.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#define popen _popen
+#define pclose _pclose
+#else
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+bool startsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+} // namespace
+
+void DpcBossac::Parser::feed(const char* data, size_t size, const EventCallback& onEvent) {
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] == '\r' || data[i] == '\n') {
+            if (!m_line.empty()) {
+                parseLine(m_line, onEvent);
+                m_line.clear();
+            }
+        } else {
+            m_line += data[i];
+        }
+    }
+}
+
+void DpcBossac::Parser::finish(const EventCallback& onEvent) {
+    if (!m_line.empty()) {
+        parseLine(m_line, onEvent);
+        m_line.clear();
+    }
+}
+
+void DpcBossac::Parser::parseLine(const std::string& line, const EventCallback& onEvent) {
+    Event event;
+    event.type = Event::Type::Info;
+    event.text = line;
+    size_t bytes = 0;
+    size_t pages = 0;
+    size_t pagesDone = 0;
+    size_t pagesTotal = 0;
+    const char* pageCount = std::strchr(line.c_str(), '(');
+
+    if (startsWith(line, "Erase flash")) {
+        m_phase = "erase";
+        m_totalBytes = 0;
+        event.type = Event::Type::PhaseStart;
+    } else if (std::sscanf(line.c_str(), "Write %zu bytes to flash (%zu pages)", &bytes, &pages) >= 1) {
+        m_phase = "write";
+        m_totalBytes = bytes;
+        event.type = Event::Type::PhaseStart;
+    } else if (std::sscanf(line.c_str(), "Verify %zu bytes of flash", &bytes) == 1) {
+        m_phase = "verify";
+        m_totalBytes = bytes;
+        event.type = Event::Type::PhaseStart;
+    } else if (startsWith(line, "Verify successful") || startsWith(line, "done in")) {
+        event.type = Event::Type::PhaseDone;
+    } else if (startsWith(line, "[") && pageCount &&
+               std::sscanf(pageCount, "(%zu/%zu pages)", &pagesDone, &pagesTotal) == 2 && pagesTotal > 0) {
+        event.type = Event::Type::Progress;
+        // Pages of the last one may be partly used: convert through the phase's byte count
+        size_t totalBytes = m_totalBytes > 0 ? m_totalBytes : pagesTotal;
+        event.done = totalBytes * pagesDone / pagesTotal;
+    } else if (startsWith(line, "CPU reset")) {
+        event.type = Event::Type::Reset;
+    } else if (startsWith(line, "Verify failed") || line.find("rror") != std::string::npos ||
+               startsWith(line, "No device found")) {
+        event.type = Event::Type::Error;
+    }
+
+    if (event.type != Event::Type::Info && event.type != Event::Type::Reset) {
+        event.phase = m_phase;
+        event.total = m_totalBytes;
+    }
+    if (event.type == Event::Type::PhaseDone) {
+        // "Verify successful" and "done in" both end the verify phase
+        m_phase.clear();
+        if (event.phase.empty()) {
+            return;
+        }
+    }
+    onEvent(event);
+}
+
+DpcBossac::DpcBossac(bool verbose) : m_verbose(verbose), m_exitCode(-1) {
+}
+
+bool DpcBossac::run(const std::string& command, const EventCallback& onEvent) {
+    m_timings.clear();
+    m_outputTail.clear();
+    m_exitCode = -1;
+
+    // Merge stderr into the pipe; on Windows _popen runs the line through cmd /c, which
+    // needs the whole command quoted once more
+#ifdef _WIN32
+    std::string pipeCommand = "\"" + command + " 2>&1\"";
+    FILE* pipe = popen(pipeCommand.c_str(), "rb");
+#else
+    std::string pipeCommand = command + " 2>&1";
+    FILE* pipe = popen(pipeCommand.c_str(), "r");
+#endif
+    if (!pipe) {
+        std::cerr << "Failed to start: " << command << std::endl;
+        return false;
+    }
+
+    std::string openPhase;
+    DpcTiming::Clock::time_point phaseStart;
+    auto handle = [&](const Event& event) {
+        if (event.type == Event::Type::PhaseStart) {
+            if (!openPhase.empty()) {
+                m_timings.record(openPhase, phaseStart, DpcTiming::Status::Completed);
+            }
+            openPhase = event.phase;
+            phaseStart = DpcTiming::Clock::now();
+        } else if (event.type == Event::Type::PhaseDone && event.phase == openPhase) {
+            m_timings.record(openPhase, phaseStart, DpcTiming::Status::Completed);
+            openPhase.clear();
+        }
+        if (event.type != Event::Type::Progress) {
+            m_outputTail.push_back(event.text);
+            if (m_outputTail.size() > OUTPUT_TAIL_LINES) {
+                m_outputTail.erase(m_outputTail.begin());
+            }
+        }
+        if (onEvent) {
+            onEvent(event);
+        }
+    };
+
+    // Read whatever is available rather than whole lines: progress bars end in '\r'
+    Parser parser;
+    char buffer[512];
+    while (true) {
+#ifdef _WIN32
+        int count = _read(_fileno(pipe), buffer, sizeof(buffer));
+#else
+        ssize_t count = ::read(fileno(pipe), buffer, sizeof(buffer));
+#endif
+        if (count <= 0) {
+            break;
+        }
+        parser.feed(buffer, static_cast<size_t>(count), handle);
+    }
+    parser.finish(handle);
+
+    int status = pclose(pipe);
+#ifdef _WIN32
+    m_exitCode = status;
+#else
+    m_exitCode = (status != -1 && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+#endif
+    if (!openPhase.empty()) {
+        m_timings.record(openPhase, phaseStart, m_exitCode == 0 ? DpcTiming::Status::Completed : DpcTiming::Status::Error);
+    }
+    if (m_verbose) {
+        std::cout << "bossac exit code: " << m_exitCode << std::endl;
+    }
+    return m_exitCode == 0;
+}
+
+int DpcBossac::getExitCode() const {
+    return m_exitCode;
+}
+
+const DpcTiming& DpcBossac::getTimings() const {
+    return m_timings;
+}
+
+const std::vector<std::string>& DpcBossac::getOutputTail() const {
+    return m_outputTail;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "DpcTiming.h"
+
+// Runs the bossac tool through a pipe and turns its output into structured events as
+// it arrives, instead of leaving the console to bossac via system().
+//
+// Recognised bossac output:
+//   Erase flash                                    -> PhaseStart "erase"
+//   Write 57436 bytes to flash (898 pages)         -> PhaseStart "write", total in bytes
+//   [=====       ] 33% (300/898 pages)             -> Progress, pages converted to bytes
+//   Verify 57436 bytes of flash [with checksum.]   -> PhaseStart "verify"
+//   done in 0.338 seconds / Verify successful      -> PhaseDone
+//   CPU reset.                                     -> Reset
+//   Verify failed, errors, "No device found"       -> Error
+class DpcBossac {
+public:
+    struct Event {
+        enum class Type { PhaseStart, Progress, PhaseDone, Reset, Error, Info };
+        Type type;
+        std::string phase;          // "erase", "write" or "verify" (empty for Info, Reset)
+        size_t done = 0;            // Bytes, for Progress
+        size_t total = 0;           // Bytes of the current phase (0: unknown)
+        std::string text;           // The output line
+    };
+    using EventCallback = std::function<void(const Event&)>;
+
+    // Incremental parser: output can be fed in arbitrary chunks; bossac redraws its
+    // progress bar with '\r', so both '\r' and '\n' end a line
+    class Parser {
+    public:
+        void feed(const char* data, size_t size, const EventCallback& onEvent);
+        void finish(const EventCallback& onEvent);     // Parse an unterminated last line
+
+    private:
+        std::string m_line;
+        std::string m_phase;
+        size_t m_totalBytes = 0;
+
+        void parseLine(const std::string& line, const EventCallback& onEvent);
+    };
+
+    explicit DpcBossac(bool verbose = false);
+
+    // Run the command line; true if bossac exited with status 0
+    bool run(const std::string& command, const EventCallback& onEvent);
+
+    int getExitCode() const;
+    // Per-phase durations as observed from the output (erase, write, verify)
+    const DpcTiming& getTimings() const;
+    // Last output lines, for error reports
+    const std::vector<std::string>& getOutputTail() const;
+
+private:
+    bool m_verbose;
+    int m_exitCode;
+    DpcTiming m_timings;
+    std::vector<std::string> m_outputTail;
+
+    static constexpr size_t OUTPUT_TAIL_LINES = 10;
+};
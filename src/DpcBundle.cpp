@@ -0,0 +1,343 @@
+#include "DpcBundle.h"
+#include "DpcSha256.h"
+#include "DpcCache.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+uint32_t readU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t readU64(const uint8_t* p) {
+    return static_cast<uint64_t>(readU32(p)) | (static_cast<uint64_t>(readU32(p + 4)) << 32);
+}
+
+void writeU32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void writeU64(uint8_t* p, uint64_t value) {
+    writeU32(p, static_cast<uint32_t>(value));
+    writeU32(p + 4, static_cast<uint32_t>(value >> 32));
+}
+
+std::string toHex(const uint8_t* bytes, size_t size) {
+    static const char hex[] = "0123456789abcdef";
+    std::string text;
+    for (size_t i = 0; i < size; ++i) {
+        text += hex[bytes[i] >> 4];
+        text += hex[bytes[i] & 0xF];
+    }
+    return text;
+}
+
+bool fromHex(const std::string& text, uint8_t* bytes, size_t size) {
+    if (text.size() != 2 * size) {
+        return false;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        unsigned value = 0;
+        if (std::sscanf(text.c_str() + 2 * i, "%2x", &value) != 1) {
+            return false;
+        }
+        bytes[i] = static_cast<uint8_t>(value);
+    }
+    return true;
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+DpcBundle::DpcBundle()
+    : m_data(nullptr), m_size(0),
+#ifdef _WIN32
+      m_file(nullptr), m_mapping(nullptr),
+#endif
+      m_entryCount(0), m_bucketCount(0), m_latestEntry(NO_ENTRY), m_bucketsOffset(0), m_entriesOffset(0),
+      m_metadataOffset(0), m_metadataSize(0) {
+}
+
+DpcBundle::~DpcBundle() {
+    close();
+}
+
+bool DpcBundle::open(const std::string& path, std::string& error) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = nullptr;
+    const void* view = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    }
+    if (!view) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        error = "cannot map " + path;
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);        // The mapping stays valid
+    if (view == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(st.st_size);
+#endif
+
+    // Check everything that lookups rely on once, so that they need no bounds checks
+    if (m_size < HEADER_SIZE || std::memcmp(m_data, MAGIC, 8) != 0 || readU32(m_data + 8) != FORMAT_VERSION) {
+        close();
+        error = path + " is not a firmware bundle";
+        return false;
+    }
+    m_entryCount = readU32(m_data + 12);
+    m_bucketCount = readU32(m_data + 16);
+    m_latestEntry = readU32(m_data + 20);
+    m_bucketsOffset = readU64(m_data + 24);
+    m_entriesOffset = readU64(m_data + 32);
+    m_metadataOffset = readU64(m_data + 40);
+    m_metadataSize = readU64(m_data + 48);
+
+    // Written as offset <= size && length <= size - offset, which cannot overflow
+    uint64_t fileSize = m_size;
+    auto inFile = [fileSize](uint64_t offset, uint64_t length) {
+        return offset <= fileSize && length <= fileSize - offset;
+    };
+    bool valid = m_bucketCount > m_entryCount && (m_bucketCount & (m_bucketCount - 1)) == 0 &&
+                 inFile(m_bucketsOffset, uint64_t(m_bucketCount) * 4) &&
+                 inFile(m_entriesOffset, uint64_t(m_entryCount) * ENTRY_SIZE) &&
+                 inFile(m_metadataOffset, m_metadataSize) &&
+                 (m_latestEntry == NO_ENTRY || m_latestEntry < m_entryCount);
+    for (uint32_t bucket = 0; valid && bucket < m_bucketCount; ++bucket) {
+        valid = readU32(m_data + m_bucketsOffset + 4 * bucket) <= m_entryCount;
+    }
+    for (uint32_t entry = 0; valid && entry < m_entryCount; ++entry) {
+        const uint8_t* record = m_data + m_entriesOffset + entry * ENTRY_SIZE;
+        uint64_t offset = readU64(record + 96);
+        uint64_t size = readU64(record + 104);
+        valid = record[TAG_FIELD_SIZE - 1] == 0 && inFile(offset, size);
+    }
+    if (!valid) {
+        close();
+        error = path + " is damaged (index out of range)";
+        return false;
+    }
+    return true;
+}
+
+void DpcBundle::close() {
+    if (!m_data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(static_cast<HANDLE>(m_mapping));
+    CloseHandle(static_cast<HANDLE>(m_file));
+    m_file = nullptr;
+    m_mapping = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_entryCount = 0;
+    m_bucketCount = 0;
+    m_latestEntry = NO_ENTRY;
+}
+
+bool DpcBundle::find(const std::string& tag, Image& image) const {
+    if (!m_data || tag.empty() || tag.size() > MAX_TAG_LENGTH) {
+        return false;
+    }
+    uint32_t mask = m_bucketCount - 1;
+    for (uint32_t bucket = hashTag(tag) & mask, probes = 0; probes < m_bucketCount; bucket = (bucket + 1) & mask, ++probes) {
+        uint32_t slot = readU32(m_data + m_bucketsOffset + 4 * bucket);
+        if (slot == 0) {
+            return false;
+        }
+        const char* entryTag = reinterpret_cast<const char*>(m_data + m_entriesOffset + (slot - 1) * ENTRY_SIZE);
+        if (tag == entryTag) {
+            image = getImage(slot - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<DpcBundle::Image> DpcBundle::list() const {
+    std::vector<Image> images;
+    for (uint32_t entry = 0; entry < m_entryCount; ++entry) {
+        images.push_back(getImage(entry));
+    }
+    return images;
+}
+
+std::string DpcBundle::getLatestTag() const {
+    return (m_data && m_latestEntry != NO_ENTRY) ? getImage(m_latestEntry).tag : "";
+}
+
+std::string DpcBundle::getMetadata() const {
+    if (!m_data) {
+        return "";
+    }
+    return std::string(reinterpret_cast<const char*>(m_data + m_metadataOffset), m_metadataSize);
+}
+
+DpcBundle::Image DpcBundle::getImage(uint32_t entry) const {
+    const uint8_t* record = m_data + m_entriesOffset + entry * ENTRY_SIZE;
+    Image image;
+    image.tag = reinterpret_cast<const char*>(record);
+    image.sha256 = toHex(record + TAG_FIELD_SIZE, 32);
+    image.data = m_data + readU64(record + 96);
+    image.size = static_cast<size_t>(readU64(record + 104));
+    return image;
+}
+
+uint32_t DpcBundle::hashTag(const std::string& tag) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : tag) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+bool DpcBundle::create(const std::string& path, const std::vector<Source>& images, const std::string& latestTag,
+                       const std::string& metadata, std::string& error) {
+    // Hash table at most half full keeps probe sequences short
+    uint32_t bucketCount = 8;
+    while (bucketCount < 2 * images.size()) {
+        bucketCount *= 2;
+    }
+    size_t bucketsOffset = HEADER_SIZE;
+    size_t entriesOffset = bucketsOffset + bucketCount * 4;
+    size_t metadataOffset = entriesOffset + images.size() * ENTRY_SIZE;
+    size_t dataOffset = alignUp(metadataOffset + metadata.size(), IMAGE_ALIGNMENT);
+
+    std::vector<uint8_t> index(dataOffset, 0);
+    std::vector<std::vector<uint8_t>> contents;
+    uint32_t latestEntry = NO_ENTRY;
+    for (size_t i = 0; i < images.size(); ++i) {
+        const Source& source = images[i];
+        if (source.tag.empty() || source.tag.size() > MAX_TAG_LENGTH) {
+            error = "invalid tag: " + source.tag;
+            return false;
+        }
+        std::ifstream file(source.path, std::ios::binary);
+        if (!file.is_open()) {
+            error = "cannot read " + source.path;
+            return false;
+        }
+        contents.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        const std::vector<uint8_t>& content = contents.back();
+
+        // Later duplicates of a tag would be unreachable
+        uint32_t mask = bucketCount - 1;
+        uint32_t bucket = hashTag(source.tag) & mask;
+        while (readU32(index.data() + bucketsOffset + 4 * bucket) != 0) {
+            uint32_t other = readU32(index.data() + bucketsOffset + 4 * bucket) - 1;
+            if (source.tag == images[other].tag) {
+                error = "duplicate tag: " + source.tag;
+                return false;
+            }
+            bucket = (bucket + 1) & mask;
+        }
+        writeU32(index.data() + bucketsOffset + 4 * bucket, static_cast<uint32_t>(i + 1));
+
+        DpcSha256 sha;
+        sha.update(content.data(), content.size());
+        uint8_t* record = index.data() + entriesOffset + i * ENTRY_SIZE;
+        std::memcpy(record, source.tag.c_str(), source.tag.size());
+        fromHex(sha.hexDigest(), record + TAG_FIELD_SIZE, 32);
+        writeU64(record + 96, dataOffset);
+        writeU64(record + 104, content.size());
+        dataOffset = alignUp(dataOffset + content.size(), IMAGE_ALIGNMENT);
+        if (source.tag == latestTag) {
+            latestEntry = static_cast<uint32_t>(i);
+        }
+    }
+
+    std::memcpy(index.data(), MAGIC, 8);
+    writeU32(index.data() + 8, FORMAT_VERSION);
+    writeU32(index.data() + 12, static_cast<uint32_t>(images.size()));
+    writeU32(index.data() + 16, bucketCount);
+    writeU32(index.data() + 20, latestEntry);
+    writeU64(index.data() + 24, bucketsOffset);
+    writeU64(index.data() + 32, entriesOffset);
+    writeU64(index.data() + 40, metadataOffset);
+    writeU64(index.data() + 48, metadata.size());
+    std::memcpy(index.data() + metadataOffset, metadata.data(), metadata.size());
+
+    // Written next to the target and renamed, so a bundle is never seen half-written
+    std::string partPath = path + ".part";
+    {
+        std::ofstream out(partPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            error = "cannot write " + partPath;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+        for (const auto& content : contents) {
+            out.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+            size_t padding = alignUp(content.size(), IMAGE_ALIGNMENT) - content.size();
+            static const char zeros[IMAGE_ALIGNMENT] = {};
+            out.write(zeros, static_cast<std::streamsize>(padding));
+        }
+        out.close();
+        if (!out || !DpcCache::syncFile(partPath)) {
+            error = "failed to write " + partPath;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(partPath, path, ec);
+    if (ec) {
+        error = "cannot move bundle into place: " + ec.message();
+        return false;
+    }
+    return true;
+}
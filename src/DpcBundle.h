@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Single-file firmware bundle for offline use: several firmware versions, their SHA-256
+// digests and the release metadata (GitHub API format), memory-mapped for reading. A
+// version is found in O(1) through a hash table over the tags, and its image is used
+// straight from the mapping without parsing JSON or reading the rest of the file.
+//
+// Layout (integers little-endian, offsets from the start of the file):
+//   header     64 bytes    "DPCBNDL1", format version, entry count, bucket count,
+//                          latest entry, offsets of buckets/entries/metadata, metadata size
+//   buckets    uint32 x bucket count (power of two): entry index + 1, 0 = empty;
+//              FNV-1a of the tag, linear probing
+//   entries    128 bytes each: tag (64, NUL-padded), SHA-256 (32), offset (8), size (8)
+//   metadata   release list JSON
+//   images     16-byte aligned
+class DpcBundle {
+public:
+    struct Image {
+        std::string tag;
+        std::string sha256;         // Hex
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // Image file to pack under a tag
+    struct Source {
+        std::string tag;
+        std::string path;
+    };
+
+    DpcBundle();
+    ~DpcBundle();
+    DpcBundle(const DpcBundle&) = delete;
+    DpcBundle& operator=(const DpcBundle&) = delete;
+
+    // Map a bundle and check its header and index; false with a reason on error
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool find(const std::string& tag, Image& image) const;
+    std::vector<Image> list() const;
+    std::string getLatestTag() const;           // Empty if the bundle names none
+    std::string getMetadata() const;            // Release list JSON as packed
+
+    static bool create(const std::string& path, const std::vector<Source>& images, const std::string& latestTag,
+                       const std::string& metadata, std::string& error);
+
+    static constexpr size_t MAX_TAG_LENGTH = 63;
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#endif
+
+    uint32_t m_entryCount;
+    uint32_t m_bucketCount;
+    uint32_t m_latestEntry;
+    uint64_t m_bucketsOffset;
+    uint64_t m_entriesOffset;
+    uint64_t m_metadataOffset;
+    uint64_t m_metadataSize;
+
+    Image getImage(uint32_t entry) const;
+    static uint32_t hashTag(const std::string& tag);
+
+    static constexpr const char* MAGIC = "DPCBNDL1";
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 64;
+    static constexpr size_t ENTRY_SIZE = 128;
+    static constexpr size_t TAG_FIELD_SIZE = 64;
+    static constexpr size_t IMAGE_ALIGNMENT = 16;
+    static constexpr uint32_t NO_ENTRY = 0xFFFFFFFF;
+};
@@ -0,0 +1,297 @@
+#include "DpcCache.h"
+#include "DpcSha256.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+DpcCache::DpcCache(bool verbose, const std::string& directory)
+    : m_verbose(verbose), m_directory(directory.empty() ? getDefaultDirectory() : directory) {
+}
+
+std::string DpcCache::getDefaultDirectory() {
+    if (const char* overrideDir = std::getenv("DIYPRESSO_CACHE_DIR")) {
+        if (*overrideDir) {
+            return overrideDir;
+        }
+    }
+#ifdef _WIN32
+    if (const char* localAppData = std::getenv("LOCALAPPDATA")) {
+        return (fs::path(localAppData) / "diyPresso" / "firmware").string();
+    }
+#elif defined(__APPLE__)
+    if (const char* home = std::getenv("HOME")) {
+        return (fs::path(home) / "Library" / "Caches" / "diyPresso" / "firmware").string();
+    }
+#else
+    if (const char* xdgCache = std::getenv("XDG_CACHE_HOME")) {
+        if (*xdgCache) {
+            return (fs::path(xdgCache) / "diyPresso" / "firmware").string();
+        }
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return (fs::path(home) / ".cache" / "diyPresso" / "firmware").string();
+    }
+#endif
+    return (fs::temp_directory_path() / "diyPresso" / "firmware").string();
+}
+
+const std::string& DpcCache::getDirectory() const {
+    return m_directory;
+}
+
+std::string DpcCache::getObjectPath(const std::string& sha256) const {
+    return (fs::path(m_directory) / OBJECTS_DIRNAME / (sha256 + ".bin")).string();
+}
+
+std::string DpcCache::getTempPath(const std::string& url) const {
+    std::string name = "download-" + DpcSha256::hash(url).substr(0, 16) + ".tmp";
+    return (fs::path(m_directory) / OBJECTS_DIRNAME / name).string();
+}
+
+bool DpcCache::ensureDirectories() {
+    std::error_code ec;
+    fs::create_directories(fs::path(m_directory) / OBJECTS_DIRNAME, ec);
+    if (ec) {
+        std::cerr << "Cannot create firmware cache directory " << m_directory << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool DpcCache::lookup(const std::string& tag, Entry& entry) {
+    nlohmann::json index = loadIndex();
+    if (tag.empty() || !index["entries"].contains(tag)) {
+        return false;
+    }
+
+    const auto& record = index["entries"][tag];
+    entry.tag = tag;
+    entry.sha256 = record.value("sha256", "");
+    entry.url = record.value("url", "");
+    entry.size = record.value("size", size_t(0));
+    entry.path = getObjectPath(entry.sha256);
+
+    // Images are small: re-hashing catches truncated or modified objects for ~1 ms
+    std::error_code ec;
+    if (!entry.sha256.empty() && fs::file_size(entry.path, ec) == entry.size && !ec &&
+        DpcSha256::hashFile(entry.path) == entry.sha256) {
+        return true;
+    }
+
+    if (m_verbose) {
+        std::cout << "Cached firmware for " << tag << " is missing or corrupt, dropping it" << std::endl;
+    }
+    fs::remove(entry.path, ec);
+    index["entries"].erase(tag);
+    saveIndex(index);
+    return false;
+}
+
+bool DpcCache::store(const std::string& tag, const std::string& url, const std::string& filePath,
+                     const std::string& sha256, Entry& entry) {
+    if (!ensureDirectories()) {
+        return false;
+    }
+
+    std::error_code ec;
+    entry.tag = tag;
+    entry.url = url;
+    entry.sha256 = sha256.empty() ? DpcSha256::hashFile(filePath) : sha256;
+    entry.size = static_cast<size_t>(fs::file_size(filePath, ec));
+    if (entry.sha256.empty() || ec) {
+        std::cerr << "Cannot read downloaded firmware: " << filePath << std::endl;
+        return false;
+    }
+    entry.path = getObjectPath(entry.sha256);
+
+    if (fs::exists(entry.path, ec)) {
+        // Identical image already stored (e.g. under another tag)
+        fs::remove(filePath, ec);
+        if (m_verbose) {
+            std::cout << "Firmware already in cache: " << entry.path << std::endl;
+        }
+    } else {
+        fs::rename(filePath, entry.path, ec);
+        if (ec) {
+            // Different file system: copy next to the object, sync, then rename, so that
+            // only a complete file appears under the object name
+            ec.clear();
+            std::string copyPath = entry.path + ".tmp";
+            fs::copy_file(filePath, copyPath, fs::copy_options::overwrite_existing, ec);
+            if (!ec && !syncFile(copyPath)) {
+                ec = std::make_error_code(std::errc::io_error);
+            }
+            if (!ec) {
+                fs::rename(copyPath, entry.path, ec);
+            }
+            if (ec) {
+                std::cerr << "Cannot store firmware in cache: " << ec.message() << std::endl;
+                std::error_code ignored;
+                fs::remove(copyPath, ignored);
+                return false;
+            }
+            fs::remove(filePath, ec);
+        }
+        if (m_verbose) {
+            std::cout << "Stored firmware in cache: " << entry.path << std::endl;
+        }
+    }
+
+    return addToIndex(entry);
+}
+
+bool DpcCache::storeData(const std::string& tag, const std::string& url, const uint8_t* data, size_t size,
+                         const std::string& sha256, Entry& entry) {
+    if (!ensureDirectories()) {
+        return false;
+    }
+    entry.tag = tag;
+    entry.url = url;
+    entry.sha256 = sha256;
+    entry.size = size;
+    entry.path = getObjectPath(sha256);
+
+    std::error_code ec;
+    if (!fs::exists(entry.path, ec)) {
+        std::string tempPath = getTempPath(url);
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        file.close();
+        if (!file || !syncFile(tempPath)) {
+            std::cerr << "Cannot write firmware to cache: " << tempPath << std::endl;
+            fs::remove(tempPath, ec);
+            return false;
+        }
+        return store(tag, url, tempPath, sha256, entry);
+    }
+    return addToIndex(entry);
+}
+
+bool DpcCache::addToIndex(const Entry& entry) {
+    if (entry.tag.empty()) {
+        return true;
+    }
+    nlohmann::json index = loadIndex();
+    index["entries"][entry.tag] = {
+        {"sha256", entry.sha256},
+        {"size", entry.size},
+        {"url", entry.url}
+    };
+    return saveIndex(index);
+}
+
+bool DpcCache::loadMetadata(const std::string& name, Metadata& metadata) const {
+    std::ifstream file(fs::path(m_directory) / API_DIRNAME / (name + ".json"));
+    if (!file.is_open()) {
+        return false;
+    }
+    try {
+        nlohmann::json record;
+        file >> record;
+        metadata.etag = record.value("etag", "");
+        metadata.lastModified = record.value("last_modified", "");
+        metadata.link = record.value("link", "");
+        metadata.body = record.at("body").get<std::string>();
+        return true;
+    } catch (const std::exception& e) {
+        if (m_verbose) {
+            std::cerr << "Ignoring unreadable cached response " << name << ": " << e.what() << std::endl;
+        }
+        return false;
+    }
+}
+
+bool DpcCache::saveMetadata(const std::string& name, const Metadata& metadata) {
+    std::error_code ec;
+    fs::path directory = fs::path(m_directory) / API_DIRNAME;
+    fs::create_directories(directory, ec);
+
+    nlohmann::json record = {
+        {"etag", metadata.etag},
+        {"last_modified", metadata.lastModified},
+        {"link", metadata.link},
+        {"body", metadata.body}
+    };
+    return writeFileAtomically(directory / (name + ".json"), record.dump());
+}
+
+bool DpcCache::writeFileAtomically(const fs::path& path, const std::string& contents) const {
+    // Write beside the target and rename over it, so readers never see a partial file
+    fs::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Cannot write cache file: " << tempPath.string() << std::endl;
+            return false;
+        }
+        file << contents;
+        file.close();
+        if (!file || !syncFile(tempPath.string())) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        std::cerr << "Cannot update cache file " << path.string() << ": " << ec.message() << std::endl;
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool DpcCache::syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool DpcCache::syncFile(const std::string& path) {
+    // Opened for writing (appending nothing): _commit needs a writable descriptor
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+    bool synced = syncFile(file);
+    std::fclose(file);
+    return synced;
+}
+
+nlohmann::json DpcCache::loadIndex() const {
+    nlohmann::json index;
+    std::ifstream file(fs::path(m_directory) / INDEX_FILENAME);
+    if (file.is_open()) {
+        try {
+            file >> index;
+        } catch (const std::exception& e) {
+            // A damaged index only costs a re-download
+            if (m_verbose) {
+                std::cerr << "Ignoring unreadable cache index: " << e.what() << std::endl;
+            }
+            index = nlohmann::json();
+        }
+    }
+    if (!index.is_object() || index.value("version", 0) != INDEX_VERSION || !index["entries"].is_object()) {
+        index = {{"version", INDEX_VERSION}, {"entries", nlohmann::json::object()}};
+    }
+    return index;
+}
+
+bool DpcCache::saveIndex(const nlohmann::json& index) const {
+    return writeFileAtomically(fs::path(m_directory) / INDEX_FILENAME, index.dump(2) + "\n");
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+
+// Content-addressed store for downloaded firmware images:
+//   <cache dir>/objects/<sha256>.bin   one file per distinct image
+//   <cache dir>/index.json             release tag -> digest, size and source URL
+//   <cache dir>/api/<name>.json         GitHub API response with its ETag/Last-Modified
+// Releases that ship an identical image share one object.
+//
+// Cache directory: %LOCALAPPDATA%\diyPresso\firmware (Windows),
+// ~/Library/Caches/diyPresso/firmware (macOS), $XDG_CACHE_HOME or ~/.cache otherwise.
+// DIYPRESSO_CACHE_DIR overrides all of these.
+class DpcCache {
+public:
+    struct Entry {
+        std::string tag;
+        std::string sha256;
+        std::string url;
+        std::string path;           // Object file in the cache
+        size_t size = 0;
+    };
+
+    // Cached API response and the validators to revalidate it with
+    struct Metadata {
+        std::string etag;
+        std::string lastModified;
+        std::string link;           // Pagination Link header
+        std::string body;
+    };
+
+    explicit DpcCache(bool verbose = false, const std::string& directory = "");
+
+    // Cached image for a release tag; false if unknown or its object is missing or corrupt
+    // (a corrupt entry is dropped from the index)
+    bool lookup(const std::string& tag, Entry& entry);
+
+    // Move a downloaded file into the store and record it under the tag. With an empty
+    // tag only the object is stored (e.g. for custom URLs, whose content may change).
+    // sha256 is the file's digest if the caller already has it, else the file is hashed.
+    bool store(const std::string& tag, const std::string& url, const std::string& filePath, const std::string& sha256,
+               Entry& entry);
+
+    // Store an image held in memory (e.g. mapped from a bundle) with its known digest
+    bool storeData(const std::string& tag, const std::string& url, const uint8_t* data, size_t size,
+                   const std::string& sha256, Entry& entry);
+
+    // Last stored response for an API request name (e.g. "releases-latest")
+    bool loadMetadata(const std::string& name, Metadata& metadata) const;
+    bool saveMetadata(const std::string& name, const Metadata& metadata);
+
+    // Create the cache directory layout if needed
+    bool ensureDirectories();
+
+    const std::string& getDirectory() const;
+    std::string getObjectPath(const std::string& sha256) const;
+    // Scratch file next to the objects (so that store() can rename rather than copy),
+    // named after the download URL so that an interrupted download can be resumed
+    std::string getTempPath(const std::string& url) const;
+
+    static std::string getDefaultDirectory();
+
+    // Flush a file through to the disk before it is renamed into place, so that a power
+    // loss cannot leave an empty file under the final name
+    static bool syncFile(std::FILE* file);
+    static bool syncFile(const std::string& path);
+
+private:
+    bool m_verbose;
+    std::string m_directory;
+
+    nlohmann::json loadIndex() const;
+    bool saveIndex(const nlohmann::json& index) const;
+    bool addToIndex(const Entry& entry);
+    bool writeFileAtomically(const std::filesystem::path& path, const std::string& contents) const;
+
+    static constexpr const char* INDEX_FILENAME = "index.json";
+    static constexpr const char* OBJECTS_DIRNAME = "objects";
+    static constexpr const char* API_DIRNAME = "api";
+    static constexpr int INDEX_VERSION = 1;
+};
@@ -23,34 +23,9 @@ public:
     static const std::string WHITE;
     static const std::string BOLD;
 
-    // Check if terminal supports colors
+    // Check if terminal supports colors (detected once; safe to call from worker threads)
     static bool is_color_supported() {
-        static bool checked = false;
-        static bool supported = false;
-        
-        if (!checked) {
-            checked = true;
-            
-            // Check if stdout is a terminal
-            if (!isatty(fileno(stdout))) {
-                supported = false;
-                return supported;
-            }
-            
-#ifdef _WIN32
-            // Try to enable ANSI support on Windows 10+
-            HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-            DWORD dwMode = 0;
-            if (GetConsoleMode(hOut, &dwMode)) {
-                dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
-                supported = SetConsoleMode(hOut, dwMode);
-            }
-#else
-            // On macOS/Linux, assume ANSI support
-            supported = true;
-#endif
-        }
-        
+        static const bool supported = detect_color_support();
         return supported;
     }
 
@@ -74,4 +49,26 @@ public:
     static std::string highlight(const std::string& text) {
         return is_color_supported() ? BOLD + text + RESET : text;
     }
+
+private:
+    static bool detect_color_support() {
+        // Check if stdout is a terminal
+        if (!isatty(fileno(stdout))) {
+            return false;
+        }
+        
+#ifdef _WIN32
+        // Try to enable ANSI support on Windows 10+
+        HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD dwMode = 0;
+        if (GetConsoleMode(hOut, &dwMode)) {
+            dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+            return SetConsoleMode(hOut, dwMode) != 0;
+        }
+        return false;
+#else
+        // On macOS/Linux, assume ANSI support
+        return true;
+#endif
+    }
 }; 
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "DpcDelta.h"
+#include "DpcSha256.h"
+#include <fstream>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+// Adler-32 style checksum over a window, rolled one byte at a time
+struct RollingHash {
+    uint32_t a = 0;
+    uint32_t b = 0;
+    size_t size = 0;
+
+    void init(const uint8_t* data, size_t length) {
+        a = 0;
+        b = 0;
+        size = length;
+        for (size_t i = 0; i < length; ++i) {
+            a += data[i];
+            b += a;
+        }
+    }
+
+    void roll(uint8_t out, uint8_t in) {
+        a += in - out;
+        b += a - static_cast<uint32_t>(size) * out;
+    }
+
+    uint32_t value() const {
+        return (b << 16) ^ a;
+    }
+};
+
+void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+bool getU32(const std::vector<uint8_t>& in, size_t& pos, uint32_t& value) {
+    if (pos + 4 > in.size()) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(in[pos + i]) << (8 * i);
+    }
+    pos += 4;
+    return true;
+}
+
+std::string sha256(const std::vector<uint8_t>& data) {
+    DpcSha256 sha;
+    sha.update(data.data(), data.size());
+    return sha.hexDigest();
+}
+
+} // namespace
+
+std::vector<uint8_t> DpcDelta::create(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target) {
+    std::vector<uint8_t> patch(MAGIC, MAGIC + MAGIC_SIZE);
+    std::string baseDigest = sha256(base);
+    std::string targetDigest = sha256(target);
+    patch.insert(patch.end(), baseDigest.begin(), baseDigest.end());
+    patch.insert(patch.end(), targetDigest.begin(), targetDigest.end());
+    putU32(patch, static_cast<uint32_t>(target.size()));
+
+    // Index the base by block. Padding and tables repeat the same block many times; a
+    // few candidates per checksum are enough and keep the scan linear.
+    std::unordered_map<uint32_t, std::vector<size_t>> blocks;
+    for (size_t offset = 0; offset + BLOCK_SIZE <= base.size(); offset += BLOCK_SIZE) {
+        RollingHash hash;
+        hash.init(base.data() + offset, BLOCK_SIZE);
+        auto& candidates = blocks[hash.value()];
+        if (candidates.size() < MAX_CANDIDATES) {
+            candidates.push_back(offset);
+        }
+    }
+
+    size_t literalStart = 0;
+    auto flushLiteral = [&](size_t end) {
+        if (end > literalStart) {
+            patch.push_back('A');
+            putU32(patch, static_cast<uint32_t>(end - literalStart));
+            patch.insert(patch.end(), target.begin() + literalStart, target.begin() + end);
+        }
+    };
+
+    size_t pos = 0;
+    RollingHash hash;
+    bool hashValid = false;
+    while (pos + BLOCK_SIZE <= target.size()) {
+        if (!hashValid) {
+            hash.init(target.data() + pos, BLOCK_SIZE);
+            hashValid = true;
+        }
+
+        // Longest verified match among the base blocks with this checksum
+        size_t bestOffset = 0;
+        size_t bestLength = 0;
+        auto candidates = blocks.find(hash.value());
+        if (candidates != blocks.end()) {
+            for (size_t offset : candidates->second) {
+                if (std::memcmp(base.data() + offset, target.data() + pos, BLOCK_SIZE) != 0) {
+                    continue;
+                }
+                size_t length = BLOCK_SIZE;
+                while (offset + length < base.size() && pos + length < target.size() &&
+                       base[offset + length] == target[pos + length]) {
+                    ++length;
+                }
+                if (length > bestLength) {
+                    bestOffset = offset;
+                    bestLength = length;
+                }
+            }
+        }
+
+        if (bestLength == 0) {
+            if (pos + BLOCK_SIZE < target.size()) {
+                hash.roll(target[pos], target[pos + BLOCK_SIZE]);
+            }
+            ++pos;
+            continue;
+        }
+
+        // Grow the match backwards into pending literal bytes
+        while (pos > literalStart && bestOffset > 0 && base[bestOffset - 1] == target[pos - 1]) {
+            --pos;
+            --bestOffset;
+            ++bestLength;
+        }
+        flushLiteral(pos);
+        patch.push_back('C');
+        putU32(patch, static_cast<uint32_t>(bestOffset));
+        putU32(patch, static_cast<uint32_t>(bestLength));
+        pos += bestLength;
+        literalStart = pos;
+        hashValid = false;
+    }
+    flushLiteral(target.size());
+    patch.push_back('E');
+    return patch;
+}
+
+bool DpcDelta::apply(const std::vector<uint8_t>& base, const std::vector<uint8_t>& patch,
+                     std::vector<uint8_t>& target, std::string& error) {
+    if (patch.size() < HEADER_SIZE || std::memcmp(patch.data(), MAGIC, MAGIC_SIZE) != 0) {
+        error = "not a firmware delta";
+        return false;
+    }
+    std::string baseDigest(patch.begin() + MAGIC_SIZE, patch.begin() + MAGIC_SIZE + DIGEST_SIZE);
+    std::string targetDigest = getTargetDigest(patch);
+    if (sha256(base) != baseDigest) {
+        error = "delta was made for a different base image";
+        return false;
+    }
+
+    size_t pos = MAGIC_SIZE + 2 * DIGEST_SIZE;
+    uint32_t targetSize = 0;
+    getU32(patch, pos, targetSize);
+    if (targetSize > MAX_TARGET_SIZE) {
+        // Checked before reserving: the size comes straight from the (untrusted) patch
+        error = "delta announces an image larger than the application flash";
+        return false;
+    }
+    target.clear();
+    target.reserve(targetSize);
+
+    while (true) {
+        if (pos >= patch.size()) {
+            error = "delta is truncated";
+            return false;
+        }
+        uint8_t op = patch[pos++];
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        if (op == 'E') {
+            break;
+        } else if (op == 'C') {
+            if (!getU32(patch, pos, offset) || !getU32(patch, pos, length) ||
+                static_cast<size_t>(offset) + length > base.size()) {
+                error = "delta copies outside the base image";
+                return false;
+            }
+            target.insert(target.end(), base.begin() + offset, base.begin() + offset + length);
+        } else if (op == 'A') {
+            if (!getU32(patch, pos, length) || pos + length > patch.size()) {
+                error = "delta is truncated";
+                return false;
+            }
+            target.insert(target.end(), patch.begin() + pos, patch.begin() + pos + length);
+            pos += length;
+        } else {
+            error = "unknown delta operation";
+            return false;
+        }
+        if (target.size() > targetSize) {
+            error = "delta produces a larger image than announced";
+            return false;
+        }
+    }
+
+    if (target.size() != targetSize || sha256(target) != targetDigest) {
+        error = "patched image does not match its SHA-256";
+        return false;
+    }
+    return true;
+}
+
+std::string DpcDelta::getTargetDigest(const std::vector<uint8_t>& patch) {
+    if (patch.size() < HEADER_SIZE || std::memcmp(patch.data(), MAGIC, MAGIC_SIZE) != 0) {
+        return "";
+    }
+    auto start = patch.begin() + MAGIC_SIZE + DIGEST_SIZE;
+    return std::string(start, start + DIGEST_SIZE);
+}
+
+bool DpcDelta::loadFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+bool DpcDelta::saveFile(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
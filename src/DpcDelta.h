@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Binary delta between two firmware images, so that an update can be fetched as a
+// small patch against an image already in the local cache (see DpcCache).
+//
+// The diff is a rolling-hash block match (as in rsync): the base image is indexed in
+// BLOCK_SIZE blocks, the target is scanned byte by byte for blocks that also occur in
+// the base, and matches are extended as far as the bytes agree. Consecutive releases
+// mostly differ by shifted code, which this turns into a few copies and short inserts.
+//
+// Patch format (integers little-endian):
+//   "DPCDELT1"                         magic
+//   64 bytes                           SHA-256 of the base image, hex
+//   64 bytes                           SHA-256 of the target image, hex
+//   uint32                             target size
+//   then operations, ended by 'E':
+//   'C' uint32 offset, uint32 length   copy bytes from the base
+//   'A' uint32 length, bytes           insert literal bytes
+class DpcDelta {
+public:
+    static std::vector<uint8_t> create(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target);
+
+    // Rebuild the target; false (with a reason) if the patch is malformed, was made for
+    // another base or does not produce the image whose digest it names
+    static bool apply(const std::vector<uint8_t>& base, const std::vector<uint8_t>& patch,
+                      std::vector<uint8_t>& target, std::string& error);
+
+    // SHA-256 of the target image named in a patch header; empty if not a patch
+    static std::string getTargetDigest(const std::vector<uint8_t>& patch);
+
+    static bool loadFile(const std::string& path, std::vector<uint8_t>& data);
+    static bool saveFile(const std::string& path, const std::vector<uint8_t>& data);
+
+    static constexpr size_t BLOCK_SIZE = 64;
+    // Application area of the SAMD21G18: 256 KB flash minus the 8 KB bootloader
+    static constexpr size_t MAX_TARGET_SIZE = 0x40000 - 0x2000;
+
+private:
+    static constexpr const char* MAGIC = "DPCDELT1";
+    static constexpr size_t MAGIC_SIZE = 8;
+    static constexpr size_t DIGEST_SIZE = 64;
+    static constexpr size_t HEADER_SIZE = MAGIC_SIZE + 2 * DIGEST_SIZE + 4;
+    static constexpr size_t MAX_CANDIDATES = 8;     // Base offsets kept per block checksum
+};
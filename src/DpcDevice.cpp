@@ -1,10 +1,12 @@
 // diyPresso Client Device Management - Platform support: macOS 13+ and Windows 10/11 only
 #include "DpcDevice.h"
+#include "DpcHotplug.h"
 #include "DpcColors.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
 #include <sstream>
+#include <algorithm>
 
 DpcDevice::DpcDevice() : serial_(std::make_unique<DpcSerial>()), connected_(false), verbose_(false) {
     clear_device_info();
@@ -15,35 +17,119 @@ DpcDevice::~DpcDevice() {
 }
 
 bool DpcDevice::find_and_connect(unsigned int baudrate) {
+    wait_timings_.clear();
+    
     // Find the device
-    bool bootloader_mode;
-    std::string port = serial_->find_controller(bootloader_mode);
+    std::vector<DpcSerial::ControllerInfo> controllers = DpcSerial::find_controllers(selector_);
+    
+    // After a bootloader reset, stay with the controller on the same USB port
+    if (!pinned_location_.empty()) {
+        for (const auto& controller : controllers) {
+            if (controller.location == pinned_location_) {
+                controllers = {controller};
+                break;
+            }
+        }
+    }
     
-    if (port.empty()) {
+    if (controllers.empty()) {
         if (verbose_) {
             std::cerr << "Device not found" << std::endl;
         }
         return false;
     }
 
+    const DpcSerial::ControllerInfo& controller = controllers.front();
+    std::cout << "Found Arduino MKR WiFi 1010 on port: " << controller.port 
+              << " (bootloader: " << (controller.bootloader_mode ? "yes" : "no") << ")" << std::endl;
+    return open_connection(controller, baudrate);
+}
+
+bool DpcDevice::reconnect_application(DpcSerial::Deadline deadline, unsigned int baudrate) {
+    wait_timings_.clear();
+    
+    // Our controller: preferably on the USB location it had in bootloader mode. The OS
+    // identifier can differ between bootloader and application (macOS re-enumerates,
+    // Windows instance IDs contain the PID), so otherwise accept a controller matching the
+    // selector that was not another controller's application before the reset.
+    auto is_our_application = [&](const DpcSerial::ControllerInfo& controller) {
+        if (controller.bootloader_mode) {
+            return false;
+        }
+        if (!pinned_location_.empty() && controller.location == pinned_location_) {
+            return true;
+        }
+        if (std::find(other_applications_.begin(), other_applications_.end(), controller.port) != other_applications_.end()) {
+            return false;
+        }
+        return selector_.empty() || controller.matches(selector_);
+    };
+    
+    auto start_time = DpcTiming::Clock::now();
+    DpcHotplug hotplug;
+    DpcSerial::ControllerInfo controller;
+    if (!hotplug.wait_for_controller(is_our_application, deadline, controller)) {
+        record_wait("application enumeration", start_time, DpcTiming::Status::Timeout);
+        return false;
+    }
+    record_wait("application enumeration", start_time, DpcTiming::Status::Completed);
+    
+    std::cout << "Found Arduino MKR WiFi 1010 on port: " << controller.port << " (bootloader: no)" << std::endl;
+    
+    // The node can appear before it is accessible: retry opening until the deadline, and
+    // only report the failure of the last attempt
+    while (!open_connection(controller, baudrate, verbose_)) {
+        if (!hotplug.wait_for_change(deadline)) {
+            if (!verbose_) {
+                std::cerr << "Failed to open serial port: " << controller.port << " (" << serial_->get_last_error() << ")" << std::endl;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void DpcDevice::set_device_selector(const std::string& selector) {
+    selector_ = selector;
+    pinned_location_.clear();
+    other_applications_.clear();
+}
+
+bool DpcDevice::connect(const std::string& port, unsigned int baudrate) {
+    wait_timings_.clear();
+    
+    DpcSerial::ControllerInfo controller;
+    controller.port = port;
+    controller.bootloader_mode = false;
+    controller.vendor_id = DpcSerial::ARDUINO_VENDOR_ID;
+    controller.product_id = DpcSerial::ARDUINO_MKR_WIFI_1010_PRODUCT_ID;
+    return open_connection(controller, baudrate);
+}
+
+bool DpcDevice::open_connection(const DpcSerial::ControllerInfo& controller, unsigned int baudrate,
+                                bool report_failure) {
     // Open the serial connection
-    if (!serial_->open(port, baudrate)) {
-        std::cerr << "Failed to open serial port: " << port << std::endl;
+    if (!serial_->open(controller.port, baudrate)) {
+        if (report_failure) {
+            std::cerr << "Failed to open serial port: " << controller.port << " (" << serial_->get_last_error() << ")" << std::endl;
+        }
         return false;
     }
 
     connected_ = true;
     
     // Update device info with the found information
-    device_info_.port = port;
-    device_info_.bootloader_mode = bootloader_mode;
-    device_info_.vendor_id = DpcSerial::ARDUINO_VENDOR_ID;
-    device_info_.product_id = bootloader_mode ? 
-        DpcSerial::ARDUINO_MKR_WIFI_1010_PRODUCT_ID_BOOTLOADER : 
-        DpcSerial::ARDUINO_MKR_WIFI_1010_PRODUCT_ID;
+    device_info_.port = controller.port;
+    device_info_.serial_number = controller.serial_number;
+    device_info_.location = controller.location;
+    device_info_.bootloader_mode = controller.bootloader_mode;
+    device_info_.vendor_id = controller.vendor_id;
+    device_info_.product_id = controller.product_id;
     
     // Get firmware version if not in bootloader mode
-    if (!bootloader_mode) {
+    if (!controller.bootloader_mode) {
+        // Drain the application's output (telemetry) continuously from here on
+        serial_->start_reader();
         device_info_.firmware_version = get_firmware_version();
     } else {
         device_info_.firmware_version = "bootloader";
@@ -58,6 +144,9 @@ bool DpcDevice::is_connected() const {
 
 void DpcDevice::disconnect() {
     if (connected_) {
+        if (verbose_ && serial_->get_dropped_lines() > 0) {
+            std::cout << "Serial line queue overflowed, dropped " << serial_->get_dropped_lines() << " lines" << std::endl;
+        }
         serial_->close();
         connected_ = false;
         clear_device_info();
@@ -112,7 +201,7 @@ std::string DpcDevice::get_firmware_version() {
     }
 }
 
-std::string DpcDevice::detect_pre_162_by_setpoint_lines() {
+std::string DpcDevice::detect_pre_162_by_setpoint_lines(int timeout_seconds) {
     if (verbose_) {
         std::cout << "Checking for setpoint lines to detect pre-1.6.2 firmware..." << std::endl;
     }
@@ -120,47 +209,38 @@ std::string DpcDevice::detect_pre_162_by_setpoint_lines() {
     // Clear any previously cached boot lines
     boot_sequence_lines_.clear();
     
-    // Wait up to 10 seconds for setpoint lines to appear
-    auto start_time = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::seconds(10);
+    // Wait until the deadline for setpoint lines to appear
+    auto start_time = DpcTiming::Clock::now();
+    auto deadline = start_time + std::chrono::seconds(timeout_seconds);
     int lines_checked = 0;
+    std::string_view line;
+    DpcSerial::ReadStatus status;
     
-    while (std::chrono::steady_clock::now() - start_time < timeout) {
-        if (serial_->is_open()) {
-            std::string line = serial_->readline();
-            lines_checked++;
-            
-            // Remove newline characters
-            if (!line.empty() && line.back() == '\n') {
-                line.pop_back();
-            }
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            
+    while ((status = serial_->readline(line, deadline)) == DpcSerial::ReadStatus::Ok) {
+        lines_checked++;
+        
+        if (verbose_) {
+            std::cout << "  Read line " << lines_checked << ": '" << line << "'" << std::endl;
+        }
+        
+        // Store all lines for later parsing by DpcSettings
+        boot_sequence_lines_.push_back(DpcSerial::retain(line));
+        
+        // Check if this line starts with "setpoint:" to confirm pre-1.6.2
+        if (is_telemetry(line)) {
             if (verbose_) {
-                std::cout << "  Read line " << lines_checked << ": '" << line << "'" << std::endl;
+                std::cout << "  Found setpoint line! Detected pre-1.6.2 firmware" << std::endl;
+                std::cout << "  Captured " << boot_sequence_lines_.size() << " lines from boot sequence" << std::endl;
             }
-            
-            // Store all lines for later parsing by DpcSettings
-            boot_sequence_lines_.push_back(line);
-            
-            // Check if this line starts with "setpoint:" to confirm pre-1.6.2
-            if (line.find("setpoint:") == 0) {
-                if (verbose_) {
-                    std::cout << "  Found setpoint line! Detected pre-1.6.2 firmware" << std::endl;
-                    std::cout << "  Captured " << boot_sequence_lines_.size() << " lines from boot sequence" << std::endl;
-                }
-                return "pre-1.6.2";
-            }
-        } else {
-            // No data available, wait a bit before checking again
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            record_wait("setpoint detection", start_time, DpcTiming::Status::Completed);
+            return "pre-1.6.2";
         }
     }
     
+    record_wait("setpoint detection", start_time, status);
+    
     if (verbose_) {
-        std::cout << "  No setpoint lines found after checking " << lines_checked << " lines for 10 seconds" << std::endl;
+        std::cout << "  No setpoint lines found after checking " << lines_checked << " lines for " << timeout_seconds << " seconds" << std::endl;
         std::cout << "  Serial available: " << (serial_->is_open() ? "yes" : "no") << std::endl;
         std::cout << "  Captured " << boot_sequence_lines_.size() << " lines from boot sequence" << std::endl;
     }
@@ -183,6 +263,10 @@ std::vector<std::string> DpcDevice::get_boot_sequence_lines() const {
 }
 
 std::vector<std::string> DpcDevice::send_command(const std::string& command, int timeout_seconds) {
+    return send_command(command, DpcSerial::Clock::now() + std::chrono::seconds(timeout_seconds));
+}
+
+std::vector<std::string> DpcDevice::send_command(const std::string& command, DpcSerial::Deadline deadline) {
     if (!is_connected()) {
         throw std::runtime_error("Device not connected");
     }
@@ -200,47 +284,43 @@ std::vector<std::string> DpcDevice::send_command(const std::string& command, int
     } else {
         throw std::runtime_error("Invalid command format: " + command);
     }
+    std::string wait_label = verb + " " + object;
 
     // Send command
+    auto start_time = DpcTiming::Clock::now();
     serial_->write(command + "\n");
     
     std::vector<std::string> lines;
-    auto start_time = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::seconds(timeout_seconds);
+    std::string_view line;
+    DpcSerial::ReadStatus status;
     
-    while (std::chrono::steady_clock::now() - start_time < timeout) {
-        if (serial_->is_open()) {
-            std::string line = serial_->readline();
-            
-            // Remove newline characters
-            if (!line.empty() && line.back() == '\n') {
-                line.pop_back();
-            }
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            
-            // Skip lines starting with "setpoint:" (monitoring data)
-            if (line.find("setpoint:") == 0) {
-                continue;
-            }
-            
-            lines.push_back(line);
-            
-            // Check for OK response (success)
-            if (line.find(expected_ok_response) == 0) {
-                return lines;
-            }
-            
-            // Check for NOK response (failure)
-            if (line.find(expected_nok_response) == 0) {
-                throw std::runtime_error("Command failed: " + line);
-            }
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    while ((status = serial_->readline(line, deadline)) == DpcSerial::ReadStatus::Ok) {
+        // Skip lines starting with "setpoint:" (monitoring data) without copying them
+        if (is_telemetry(line)) {
+            continue;
+        }
+        
+        // Response lines outlive the receive buffer
+        lines.push_back(DpcSerial::retain(line));
+        
+        // Check for OK response (success)
+        if (starts_with(line, expected_ok_response)) {
+            record_wait(wait_label, start_time, DpcTiming::Status::Completed);
+            return lines;
+        }
+        
+        // Check for NOK response (failure)
+        if (starts_with(line, expected_nok_response)) {
+            record_wait(wait_label, start_time, DpcTiming::Status::Completed);
+            throw std::runtime_error("Command failed: " + lines.back());
         }
     }
     
+    record_wait(wait_label, start_time, status);
+    
+    if (status != DpcSerial::ReadStatus::Timeout) {
+        throw std::runtime_error("Serial connection lost while waiting for response to: " + command);
+    }
     throw std::runtime_error("Timeout waiting for response to: " + command);
 }
 
@@ -250,73 +330,103 @@ bool DpcDevice::reset_to_bootloader() {
     }
 
     std::string original_port = device_info_.port;
+    std::string original_location = device_info_.location;
     
     if (verbose_) {
         std::cout << "Attempting to reset device to bootloader mode..." << std::endl;
         std::cout << "Original port: " << original_port << std::endl;
     }
     
-    // Close current connection and ensure port is fully released
+    // Bootloaders already present belong to other controllers, unless on our USB location;
+    // so do the applications on other ports, when our application comes back after flashing
+    std::vector<std::string> other_bootloaders;
+    other_applications_.clear();
+    for (const auto& controller : DpcSerial::list_controllers()) {
+        if (controller.bootloader_mode) {
+            other_bootloaders.push_back(controller.port);
+        } else if (controller.port != original_port) {
+            other_applications_.push_back(controller.port);
+        }
+    }
+    
+    // Close current connection
     serial_->close();
     connected_ = false;
-    
-    // Critical: Wait for the OS to fully release the port
-    if (verbose_) {
-        std::cout << "Waiting for port to be fully released..." << std::endl;
-    }
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
-    // Use the working reset implementation from DpcSerial
-    if (!DpcSerial::reset_to_bootloader(original_port, verbose_)) {
-        if (verbose_) {
-            std::cout << "Failed to send reset signal" << std::endl;
+    // Watch for the bootloader's port before resetting, so its arrival cannot be missed
+    DpcHotplug hotplug;
+
+    // The 1200 baud open fails until the OS has released the port: retry it until then,
+    // backing off from a few milliseconds
+    auto release_start = DpcTiming::Clock::now();
+    auto release_deadline = release_start + PORT_RELEASE_TIMEOUT;
+    auto retry_delay = std::chrono::milliseconds(5);
+    while (!DpcSerial::reset_to_bootloader(original_port, verbose_)) {
+        if (DpcTiming::Clock::now() + retry_delay >= release_deadline) {
+            record_wait("port release", release_start, DpcTiming::Status::Timeout);
+            if (verbose_) {
+                std::cout << "Failed to send reset signal" << std::endl;
+            }
+            return false;
         }
-        return false;
+        std::this_thread::sleep_for(retry_delay);
+        retry_delay = std::min(retry_delay * 2, std::chrono::milliseconds(100));
     }
+    record_wait("port release", release_start, DpcTiming::Status::Completed);
     
     if (verbose_) {
-        std::cout << "Reset signal sent, waiting for device re-enumeration..." << std::endl;
+        std::cout << "Reset signal sent, waiting for device re-enumeration"
+                  << (hotplug.is_event_driven() ? " (hotplug events)" : " (polling)") << "..." << std::endl;
     }
     
-    // Wait for device to reset and re-enumerate
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-
-    // Search for device in bootloader mode
-    bool bootloader_mode;
-    std::string bootloader_port;
-    
-    // Search for up to 10 seconds for the bootloader to appear
-    auto start_time = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::seconds(10);
+    // Wait up to 10 seconds for our bootloader to appear, woken by device node events.
+    // With several controllers attached it is recognised by USB location, or as a
+    // bootloader that was not there before the reset.
+    auto start_time = DpcTiming::Clock::now();
+    auto deadline = start_time + BOOTLOADER_ENUMERATION_TIMEOUT;
+    auto is_our_bootloader = [&](const DpcSerial::ControllerInfo& controller) {
+        if (!controller.bootloader_mode) {
+            return false;
+        }
+        if (!original_location.empty() && controller.location == original_location) {
+            return true;
+        }
+        return std::find(other_bootloaders.begin(), other_bootloaders.end(), controller.port) == other_bootloaders.end();
+    };
+    DpcSerial::ControllerInfo bootloader;
     
-    while (std::chrono::steady_clock::now() - start_time < timeout) {
-        bootloader_port = serial_->find_controller(bootloader_mode);
+    while (hotplug.wait_for_controller(is_our_bootloader, deadline, bootloader)) {
+        if (verbose_) {
+            std::cout << "Found device in bootloader mode on port: " << bootloader.port << std::endl;
+        }
         
-        if (!bootloader_port.empty() && bootloader_mode) {
-            if (verbose_) {
-                std::cout << "Found device in bootloader mode on port: " << bootloader_port << std::endl;
-            }
+        // Connect to bootloader; the port may not be accessible yet right after it appears
+        if (serial_->open(bootloader.port, 115200)) {
+            connected_ = true;
+            device_info_.port = bootloader.port;
+            device_info_.serial_number = bootloader.serial_number;
+            device_info_.location = bootloader.location;
+            device_info_.bootloader_mode = true;
+            device_info_.firmware_version = "bootloader";
+            device_info_.vendor_id = bootloader.vendor_id;
+            device_info_.product_id = bootloader.product_id;
             
-            // Connect to bootloader
-            if (serial_->open(bootloader_port, 115200)) {
-                connected_ = true;
-                device_info_.port = bootloader_port;
-                device_info_.bootloader_mode = true;
-                device_info_.firmware_version = "bootloader";
-                device_info_.vendor_id = DpcSerial::ARDUINO_VENDOR_ID;
-                device_info_.product_id = DpcSerial::ARDUINO_MKR_WIFI_1010_PRODUCT_ID_BOOTLOADER;
-                
-                if (verbose_) {
-                    std::cout << "Successfully connected to bootloader" << std::endl;
-                }
-                return true;
+            // Reconnects after flashing look for the controller on this USB location
+            pinned_location_ = bootloader.location;
+            
+            record_wait("bootloader enumeration", start_time, DpcTiming::Status::Completed);
+            if (verbose_) {
+                std::cout << "Successfully connected to bootloader" << std::endl;
             }
+            return true;
         }
         
-        // Wait a bit before trying again
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!hotplug.wait_for_change(deadline)) {
+            break;
+        }
     }
     
+    record_wait("bootloader enumeration", start_time, DpcTiming::Status::Timeout);
     if (verbose_) {
         std::cout << "Timeout - no bootloader found after reset" << std::endl;
     }
@@ -343,6 +453,10 @@ void DpcDevice::set_verbose(bool verbose) {
     }
 }
 
+const DpcTiming& DpcDevice::get_wait_timings() const {
+    return wait_timings_;
+}
+
 // Private helper methods
 
 void DpcDevice::update_device_info() {
@@ -359,6 +473,8 @@ void DpcDevice::update_device_info() {
 
 void DpcDevice::clear_device_info() {
     device_info_.port = "";
+    device_info_.serial_number = "";
+    device_info_.location = "";
     device_info_.firmware_version = "unknown";
     device_info_.bootloader_mode = false;
     device_info_.vendor_id = 0;
@@ -366,51 +482,42 @@ void DpcDevice::clear_device_info() {
     boot_sequence_lines_.clear();
 }
 
-bool DpcDevice::wait_for_boot_sequence_completion() {
+bool DpcDevice::wait_for_boot_sequence_completion(int timeout_seconds) {
     if (verbose_) {
         std::cout << "Waiting for device boot sequence to complete..." << std::endl;
     }
     
-    // Wait up to 10 seconds for the first "setpoint:" line (indicates boot complete for ALL firmware)
-    auto start_time = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::seconds(10);
+    // Wait for the first "setpoint:" line (indicates boot complete for ALL firmware)
+    auto start_time = DpcTiming::Clock::now();
+    auto deadline = start_time + std::chrono::seconds(timeout_seconds);
     int lines_checked = 0;
+    std::string_view line;
+    DpcSerial::ReadStatus status;
     
-    while (std::chrono::steady_clock::now() - start_time < timeout) {
-        if (serial_->is_open()) {
-            std::string line = serial_->readline();
-            lines_checked++;
-            
-            // Remove newline characters
-            if (!line.empty() && line.back() == '\n') {
-                line.pop_back();
-            }
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            
+    while ((status = serial_->readline(line, deadline)) == DpcSerial::ReadStatus::Ok) {
+        lines_checked++;
+        
+        if (verbose_) {
+            std::cout << "  Boot line " << lines_checked << ": '" << line << "'" << std::endl;
+        }
+        
+        // Store all lines for later parsing by DpcSettings
+        boot_sequence_lines_.push_back(DpcSerial::retain(line));
+        
+        // Check for first setpoint line - this indicates boot sequence is complete
+        if (is_telemetry(line)) {
+            record_wait("boot sequence", start_time, DpcTiming::Status::Completed);
             if (verbose_) {
-                std::cout << "  Boot line " << lines_checked << ": '" << line << "'" << std::endl;
-            }
-            
-            // Store all lines for later parsing by DpcSettings
-            boot_sequence_lines_.push_back(line);
-            
-            // Check for first setpoint line - this indicates boot sequence is complete
-            if (line.find("setpoint:") == 0) {
-                if (verbose_) {
-                    std::cout << "  Found first setpoint line - boot sequence completed!" << std::endl;
-                }
-                return true;
+                std::cout << "  Found first setpoint line - boot sequence completed!" << std::endl;
             }
-        } else {
-            // No data available, wait a bit before checking again
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            return true;
         }
     }
     
+    record_wait("boot sequence", start_time, status);
+    
     if (verbose_) {
-        std::cout << "  Timeout: No setpoint lines found after " << lines_checked << " lines in 10 seconds" << std::endl;
+        std::cout << "  Timeout: No setpoint lines found after " << lines_checked << " lines in " << timeout_seconds << " seconds" << std::endl;
         std::cout << "  Device may not be functioning properly" << std::endl;
         std::cout << "  Captured " << boot_sequence_lines_.size() << " lines from boot sequence" << std::endl;
     }
@@ -419,10 +526,42 @@ bool DpcDevice::wait_for_boot_sequence_completion() {
     return false;
 }
 
+void DpcDevice::record_wait(const std::string& label, DpcTiming::Clock::time_point start, DpcTiming::Status status) {
+    const auto& entry = wait_timings_.record(label, start, status);
+    if (verbose_) {
+        std::cout << "[WAIT]";
+        DpcTiming::print_entry(std::cout, entry);
+    }
+}
+
+void DpcDevice::record_wait(const std::string& label, DpcTiming::Clock::time_point start, DpcSerial::ReadStatus status) {
+    DpcTiming::Status wait_status = DpcTiming::Status::Timeout;
+    if (status == DpcSerial::ReadStatus::Closed) {
+        wait_status = DpcTiming::Status::Closed;
+    } else if (status == DpcSerial::ReadStatus::Error) {
+        wait_status = DpcTiming::Status::Error;
+    }
+    const auto& entry = wait_timings_.record(label, start, wait_status);
+    if (verbose_) {
+        std::cout << "[WAIT]";
+        DpcTiming::print_entry(std::cout, entry);
+    }
+}
+
+bool DpcDevice::starts_with(std::string_view line, std::string_view prefix) {
+    return line.substr(0, prefix.size()) == prefix;
+}
+
+bool DpcDevice::is_telemetry(std::string_view line) {
+    return starts_with(line, "setpoint:");
+}
+
 // DeviceInfo JSON conversion
 nlohmann::json DpcDevice::DeviceInfo::to_json() const {
     return nlohmann::json{
         {"port", port},
+        {"serial_number", serial_number},
+        {"location", location},
         {"firmware_version", firmware_version},
         {"bootloader_mode", bootloader_mode},
         {"vendor_id", vendor_id},
@@ -1,7 +1,9 @@
 // diyPresso Client Device Management - Platform support: macOS 13+ and Windows 10/11 only
 #pragma once
 #include "DpcSerial.h"
+#include "DpcTiming.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <nlohmann/json.hpp>
@@ -11,6 +13,8 @@ public:
     // Device info structure
     struct DeviceInfo {
         std::string port;
+        std::string serial_number;
+        std::string location;
         std::string firmware_version;
         bool bootloader_mode;
         uint16_t vendor_id;
@@ -24,7 +28,11 @@ public:
     ~DpcDevice();
 
     // Device detection and connection
-    bool find_and_connect(unsigned int baudrate = 115200);
+    bool find_and_connect(unsigned int baudrate = 115200);    // Controller matching the device selector
+    void set_device_selector(const std::string& selector);     // Port, serial number or location; empty: any
+    bool connect(const std::string& port, unsigned int baudrate = 115200);  // Known port (e.g. simulator), no USB lookup
+    // After flashing: wait for the controller to enumerate in application mode, then connect
+    bool reconnect_application(DpcSerial::Deadline deadline, unsigned int baudrate = 115200);
     bool is_connected() const;
     void disconnect();
 
@@ -38,8 +46,9 @@ public:
 
 
 
-    // Command/response protocol handling
+    // Command/response protocol handling (throws on NOK, timeout or lost connection)
     std::vector<std::string> send_command(const std::string& command, int timeout_seconds = 5);
+    std::vector<std::string> send_command(const std::string& command, DpcSerial::Deadline deadline);
 
     // Bootloader operations
     bool reset_to_bootloader();
@@ -54,16 +63,35 @@ public:
     // Verbose mode control
     void set_verbose(bool verbose);
 
+    // Time spent in each protocol wait since the last connect
+    const DpcTiming& get_wait_timings() const;
+
 private:
     std::unique_ptr<DpcSerial> serial_;
     DeviceInfo device_info_;
     bool connected_;
     bool verbose_;
+    std::string selector_;
+    std::string pinned_location_;   // USB location of the controller after a bootloader reset
+    std::vector<std::string> other_applications_;  // Ports of other controllers' applications at that reset
     std::vector<std::string> boot_sequence_lines_; // Raw lines from boot sequence
+    DpcTiming wait_timings_;
+
+    // Protocol wait budgets
+    static constexpr int BOOT_SEQUENCE_TIMEOUT_SECONDS = 10;
+    static constexpr std::chrono::seconds PORT_RELEASE_TIMEOUT{3};
+    static constexpr std::chrono::seconds BOOTLOADER_ENUMERATION_TIMEOUT{10};
 
     // Helper methods
     void update_device_info();
     void clear_device_info();
-    std::string detect_pre_162_by_setpoint_lines();
-    bool wait_for_boot_sequence_completion();
+    bool open_connection(const DpcSerial::ControllerInfo& controller, unsigned int baudrate,
+                         bool report_failure = true);
+    std::string detect_pre_162_by_setpoint_lines(int timeout_seconds = BOOT_SEQUENCE_TIMEOUT_SECONDS);
+    bool wait_for_boot_sequence_completion(int timeout_seconds = BOOT_SEQUENCE_TIMEOUT_SECONDS);
+    void record_wait(const std::string& label, DpcTiming::Clock::time_point start, DpcTiming::Status status);
+    // A serial wait that ended without its line, labelled with why it ended
+    void record_wait(const std::string& label, DpcTiming::Clock::time_point start, DpcSerial::ReadStatus status);
+    static bool starts_with(std::string_view line, std::string_view prefix);
+    static bool is_telemetry(std::string_view line);    // "setpoint:" monitoring line
 }; 
\ No newline at end of file
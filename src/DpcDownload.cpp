@@ -1,94 +1,207 @@
 #include "DpcDownload.h"
 #include "DpcColors.h"
+#include "DpcCache.h"
+#include "DpcSha256.h"
+#include "DpcDelta.h"
+#include "DpcProgress.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 #include <cpr/cpr.h>
 #include <nlohmann/json.hpp>
-#include <chrono>
-#include <iomanip>
-#include <sstream>
 #include <algorithm>
-#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <thread>
+#include <atomic>
+#include <exception>
 
-DpcDownload::DpcDownload(bool verbose) : m_verbose(verbose) {
+namespace {
+
+// Value of a raw "Name: value\r\n" header line if it has the given (case-insensitive) name
+bool headerValue(std::string_view line, const std::string& name, std::string& value) {
+    if (line.size() <= name.size() || line[name.size()] != ':') {
+        return false;
+    }
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(line[i])) != std::tolower(static_cast<unsigned char>(name[i]))) {
+            return false;
+        }
+    }
+    value = std::string(line.substr(name.size() + 1));
+    size_t start = value.find_first_not_of(" \t");
+    size_t end = value.find_last_not_of(" \t\r\n");
+    value = (start == std::string::npos) ? "" : value.substr(start, end - start + 1);
+    return true;
+}
+
+} // namespace
+
+DpcDownload::DpcDownload(bool verbose) : m_verbose(verbose), m_offline(false), m_source(Source::GitHub) {
+}
+
+void DpcDownload::setOffline(bool offline) {
+    m_offline = offline;
+}
+
+bool DpcDownload::setSource(const std::string& spec) {
+    if (spec.empty() || spec == "github") {
+        m_source = Source::GitHub;
+        m_sourceBase.clear();
+        return true;
+    }
+    
+    std::string base = spec;
+    while (base.size() > 1 && base.back() == '/') {
+        base.pop_back();
+    }
+    if (base.compare(0, 7, "http://") == 0 || base.compare(0, 8, "https://") == 0) {
+        m_source = Source::HttpMirror;
+        m_sourceBase = base;
+        return true;
+    }
+    
+    std::string path = (base.compare(0, 7, "file://") == 0) ? filePathFromUrl(base) : base;
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(path, ec)) {
+        std::string error;
+        if (!m_bundle.open(path, error)) {
+            std::cerr << DpcColors::error("Cannot use firmware bundle: " + error) << std::endl;
+            return false;
+        }
+        m_source = Source::Bundle;
+        m_sourceBase = path;
+        return true;
+    }
+    if (!std::filesystem::is_directory(path, ec)) {
+        std::cerr << DpcColors::error("Firmware mirror directory not found: " + path) << std::endl;
+        return false;
+    }
+    std::string absolute = std::filesystem::absolute(path, ec).generic_string();
+    m_source = Source::FileMirror;
+    m_sourceBase = "file://" + std::string(absolute.compare(0, 1, "/") == 0 ? "" : "/") + absolute;
+    return true;
+}
+
+std::string DpcDownload::getSourceName() const {
+    return (m_source == Source::GitHub) ? "GitHub" : m_sourceBase;
 }
 
 std::string DpcDownload::downloadFirmware(const std::string& version, const std::string& customUrl, const std::string& outputPath) {
-    std::cout << DpcColors::highlight("=== diyPresso Firmware Download ===") << std::endl;
+    std::string cachedPath = fetchFirmware(version, customUrl);
+    if (cachedPath.empty()) {
+        return "";
+    }
     
-    // Determine output path
+    // Materialize the cached image at the output path, through a scratch copy so that
+    // an existing file is replaced only by a complete one
     std::string finalOutputPath = outputPath.empty() ? getDefaultOutputPath() : outputPath;
-    std::string backupPath; // Store backup path for later comparison
-    
-    if (m_verbose) {
-        std::cout << "Output path: " << finalOutputPath << std::endl;
+    std::string partPath = finalOutputPath + ".part";
+    std::error_code ec;
+    std::filesystem::copy_file(cachedPath, partPath, std::filesystem::copy_options::overwrite_existing, ec);
+    if (!ec && !DpcCache::syncFile(partPath)) {
+        ec = std::make_error_code(std::errc::io_error);
+    }
+    if (!ec) {
+        std::filesystem::rename(partPath, finalOutputPath, ec);
+    }
+    if (ec) {
+        std::filesystem::remove(partPath, ec);
+        std::cerr << DpcColors::error("Failed to write " + finalOutputPath + ": " + ec.message()) << std::endl;
+        return "";
     }
     
-    // Check if firmware already exists and backup if needed
-    if (checkExistingFirmware(finalOutputPath)) {
-        std::cout << "Existing firmware found: " << finalOutputPath << std::endl;
-        
-        // Backup existing file
-        backupPath = backupExistingFile(finalOutputPath);
-        if (backupPath.empty()) {
-            std::cerr << DpcColors::warning("Failed to backup existing firmware file") << std::endl;
-        } else {
-            std::cout << "Backed up existing firmware" << std::endl;
-        }
+    std::cout << DpcColors::ok("Firmware saved to: " + finalOutputPath) << std::endl;
+    return finalOutputPath;
+}
+
+std::string DpcDownload::fetchFirmware(const std::string& version, const std::string& customUrl) {
+    std::cout << DpcColors::highlight("=== diyPresso Firmware Download ===") << std::endl;
+    
+    DpcCache cache(m_verbose);
+    DpcCache::Entry entry;
+    if (m_verbose) {
+        std::cout << "Firmware cache: " << cache.getDirectory() << std::endl;
     }
     
-    // Determine download URL
+    // Determine download URL; release tags are served from the cache when present
+    std::string tag;
     std::string downloadUrl;
     if (!customUrl.empty()) {
         downloadUrl = customUrl;
         std::cout << "Using custom URL: " << downloadUrl << std::endl;
     } else {
-        std::string targetVersion = version;
+        tag = version;
         if (version == "latest") {
-            targetVersion = getLatestVersionTag();
-            if (targetVersion.empty()) {
-                std::cerr << DpcColors::error("Failed to get latest version from GitHub") << std::endl;
+            tag = getLatestVersionTag();
+            if (tag.empty()) {
+                std::cerr << DpcColors::error("Failed to get latest version from " + getSourceName()) << std::endl;
                 return "";
             }
-            std::cout << "Latest version: " << targetVersion << std::endl;
+            std::cout << "Latest version: " << tag << std::endl;
+        }
+        
+        if (cache.lookup(tag, entry)) {
+            std::cout << DpcColors::ok("Using cached firmware " + tag + " (sha256 " + entry.sha256.substr(0, 12) + ")") << std::endl;
+            return entry.path;
+        }
+        if (m_source == Source::Bundle) {
+            return extractFromBundle(cache, tag, entry) ? entry.path : "";
         }
         
-        downloadUrl = buildDownloadUrl(targetVersion);
-        std::cout << "Downloading firmware version: " << targetVersion << std::endl;
+        downloadUrl = buildDownloadUrl(tag);
+        std::cout << "Downloading firmware version: " << tag << std::endl;
+    }
+    
+    if (m_offline && m_source != Source::FileMirror) {
+        std::cerr << DpcColors::error("Firmware is not in the local cache (offline mode)") << std::endl;
+        return "";
     }
     
     if (m_verbose) {
         std::cout << "Download URL: " << downloadUrl << std::endl;
     }
     
-    // Download the file
+    // Download into the cache directory, then move the verified file into the store.
+    // The scratch name depends on the URL only, so an interrupted download resumes.
+    if (!cache.ensureDirectories()) {
+        return "";
+    }
+    std::string tempPath = cache.getTempPath(downloadUrl);
+    nlohmann::json release = tag.empty() ? nlohmann::json() : findCachedRelease(tag);
+    std::string expectedSha256 = findPublishedDigest(release);
+    if (m_verbose && !expectedSha256.empty()) {
+        std::cout << "Published SHA-256: " << expectedSha256 << std::endl;
+    }
+    if (fetchDelta(cache, release, tag, expectedSha256, entry)) {
+        return entry.path;
+    }
     std::cout << "Downloading firmware..." << std::endl;
-    if (!downloadFile(downloadUrl, finalOutputPath)) {
+    DownloadedFile downloaded;
+    if (!downloadFile(downloadUrl, tempPath, expectedSha256, downloaded)) {
         std::cerr << DpcColors::error("Failed to download firmware") << std::endl;
         return "";
     }
     
-    // Validate downloaded file
-    if (!validateFirmwareFile(finalOutputPath)) {
+    // Size and digest come from the download itself; no need to read the file again
+    if (!validateFirmwareSize(downloaded.size)) {
         std::cerr << DpcColors::error("Downloaded firmware file validation failed") << std::endl;
+        removeFile(tempPath);
         return "";
     }
+    if (std::filesystem::exists(cache.getObjectPath(downloaded.sha256))) {
+        std::cout << "Downloaded firmware is identical to an image already in the cache" << std::endl;
+    }
     
-    // Check if we have a backup and if the files are identical
-    if (!backupPath.empty() && filesAreIdentical(finalOutputPath, backupPath)) {
-        if (removeFile(backupPath)) {
-            std::cout << DpcColors::ok("Firmware downloaded successfully to: " + finalOutputPath) << std::endl;
-            std::cout << DpcColors::ok("Downloaded firmware is identical to previous version - backup removed") << std::endl;
-        } else {
-            std::cout << DpcColors::ok("Firmware downloaded successfully to: " + finalOutputPath) << std::endl;
-            std::cout << DpcColors::warning("Downloaded firmware is identical to previous version but backup cleanup failed") << std::endl;
-        }
-    } else {
-        std::cout << DpcColors::ok("Firmware downloaded successfully to: " + finalOutputPath) << std::endl;
+    if (!cache.store(tag, downloadUrl, tempPath, downloaded.sha256, entry)) {
+        std::cerr << DpcColors::error("Failed to store firmware in cache") << std::endl;
+        removeFile(tempPath);
+        return "";
     }
     
-    return finalOutputPath;
+    std::cout << DpcColors::ok("Firmware downloaded successfully (sha256 " + entry.sha256.substr(0, 12) + ")") << std::endl;
+    return entry.path;
 }
 
 bool DpcDownload::checkExistingFirmware(const std::string& outputPath) {
@@ -128,101 +241,667 @@ std::vector<std::string> DpcDownload::getAvailableVersions() {
 }
 
 nlohmann::json DpcDownload::getLatestRelease() {
-    std::string url = std::string(GITHUB_API_BASE) + "/releases/latest";
-    
-    if (m_verbose) {
-        std::cout << "Fetching latest release info from: " << url << std::endl;
+    if (m_source != Source::GitHub) {
+        nlohmann::json releases = getSourceReleases();
+        if (releases.empty()) {
+            throw std::runtime_error("Firmware source lists no releases: " + m_sourceBase);
+        }
+        // A bundle names its latest version; mirrors list the newest release first
+        std::string latestTag = (m_source == Source::Bundle) ? m_bundle.getLatestTag() : "";
+        for (const auto& release : releases) {
+            if (release.value("tag_name", "") == latestTag) {
+                return release;
+            }
+        }
+        return releases[0];
+    }
+    return fetchApiJson("/releases/latest", "releases-latest");
+}
+
+nlohmann::json DpcDownload::getAllReleases() {
+    if (m_source != Source::GitHub) {
+        return getSourceReleases();
     }
     
-    cpr::Response r = cpr::Get(cpr::Url{url});
+    // GitHub pages the release list; the Link header of the first page names the next
+    // and the last page
+    std::string firstUrl = std::string(GITHUB_API_BASE) + "/releases?per_page=" + std::to_string(RELEASES_PER_PAGE);
+    ApiResponse first = fetchApi(m_api, firstUrl, "releases");
+    nlohmann::json releases = first.body;
+    std::map<std::string, std::string> links = parseLinkHeader(first.link);
+    
+    // Read-only copy for the workers: operator[] on the shared map is not thread-safe
+    const std::string lastUrl = links.count("last") ? links["last"] : "";
+    size_t lastPage = lastUrl.empty() ? 0 : getPageNumber(lastUrl);
+    if (lastPage > 1) {
+        // Page count known: fetch the remaining pages concurrently, one connection each
+        size_t pageCount = lastPage - 1;
+        std::vector<ApiResponse> pages(pageCount);
+        std::vector<std::exception_ptr> errors(pageCount);
+        std::atomic<size_t> nextPage{0};
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < std::min(pageCount, MAX_PAGE_CONNECTIONS); ++i) {
+            workers.emplace_back([&, lastUrl]() {
+                DpcHttp http;
+                for (size_t page = nextPage++; page < pageCount; page = nextPage++) {
+                    try {
+                        size_t number = page + 2;
+                        pages[page] = fetchApi(http, setPageNumber(lastUrl, number),
+                                               "releases-page-" + std::to_string(number));
+                    } catch (...) {
+                        errors[page] = std::current_exception();
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (size_t page = 0; page < pageCount; ++page) {
+            if (errors[page]) {
+                std::rethrow_exception(errors[page]);
+            }
+            releases.insert(releases.end(), pages[page].body.begin(), pages[page].body.end());
+        }
+    } else {
+        // No last page given: follow the next links one by one
+        for (size_t number = 2; links.count("next"); ++number) {
+            ApiResponse page = fetchApi(m_api, links["next"], "releases-page-" + std::to_string(number));
+            releases.insert(releases.end(), page.body.begin(), page.body.end());
+            links = parseLinkHeader(page.link);
+        }
+    }
+    return releases;
+}
+
+std::map<std::string, std::string> DpcDownload::parseLinkHeader(const std::string& header) {
+    // <https://api.github.com/...&page=2>; rel="next", <https://api.github.com/...&page=5>; rel="last"
+    std::map<std::string, std::string> links;
+    size_t pos = 0;
+    while ((pos = header.find('<', pos)) != std::string::npos) {
+        size_t urlEnd = header.find('>', pos);
+        size_t relStart = header.find("rel=\"", urlEnd);
+        if (urlEnd == std::string::npos || relStart == std::string::npos) {
+            break;
+        }
+        relStart += 5;
+        size_t relEnd = header.find('"', relStart);
+        if (relEnd == std::string::npos) {
+            break;
+        }
+        links[header.substr(relStart, relEnd - relStart)] = header.substr(pos + 1, urlEnd - pos - 1);
+        pos = relEnd;
+    }
+    return links;
+}
+
+size_t DpcDownload::getPageNumber(const std::string& url) {
+    for (const char* key : {"?page=", "&page="}) {
+        size_t pos = url.find(key);
+        if (pos != std::string::npos) {
+            return std::strtoul(url.c_str() + pos + 6, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+std::string DpcDownload::setPageNumber(const std::string& url, size_t page) {
+    for (const char* key : {"?page=", "&page="}) {
+        size_t pos = url.find(key);
+        if (pos != std::string::npos) {
+            size_t end = url.find('&', pos + 6);
+            return url.substr(0, pos + 6) + std::to_string(page) + (end == std::string::npos ? "" : url.substr(end));
+        }
+    }
+    return url + (url.find('?') == std::string::npos ? "?page=" : "&page=") + std::to_string(page);
+}
+
+nlohmann::json DpcDownload::getSourceReleases() {
+    if (m_source == Source::Bundle) {
+        return getBundleReleases();
+    }
+    nlohmann::json releases;
+    if (m_source == Source::FileMirror) {
+        std::string indexPath = filePathFromUrl(m_sourceBase + "/" + MIRROR_INDEX);
+        std::ifstream file(indexPath);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot read firmware mirror index: " + indexPath);
+        }
+        releases = nlohmann::json::parse(file);
+    } else {
+        std::string cacheName = "mirror-" + DpcSha256::hash(m_sourceBase).substr(0, 12) + "-releases";
+        releases = fetchApi(m_api, m_sourceBase + "/" + MIRROR_INDEX, cacheName).body;
+    }
+    if (!releases.is_array()) {
+        throw std::runtime_error("Firmware mirror index is not a release list");
+    }
     
-    if (r.status_code != 200) {
-        throw std::runtime_error("HTTP request failed with status: " + std::to_string(r.status_code));
+    // Resolve asset URLs against the release directory
+    for (auto& release : releases) {
+        std::string tag = release.value("tag_name", "");
+        if (!release.contains("assets")) {
+            continue;
+        }
+        for (auto& asset : release["assets"]) {
+            std::string url = asset.value("browser_download_url", "");
+            if (url.find("://") == std::string::npos) {
+                asset["browser_download_url"] = m_sourceBase + "/" + tag + "/" + (url.empty() ? asset.value("name", "") : url);
+            }
+        }
+    }
+    return releases;
+}
+
+nlohmann::json DpcDownload::getBundleReleases() {
+    // The packed release metadata, limited to the versions the bundle holds; images
+    // without metadata still get a minimal entry
+    nlohmann::json metadata = nlohmann::json::parse(m_bundle.getMetadata(), nullptr, false);
+    nlohmann::json releases = nlohmann::json::array();
+    std::vector<std::string> described;
+    if (metadata.is_array()) {
+        for (const auto& release : metadata) {
+            std::string tag = release.value("tag_name", "");
+            DpcBundle::Image image;
+            if (m_bundle.find(tag, image)) {
+                releases.push_back(release);
+                described.push_back(tag);
+            }
+        }
+    }
+    for (const auto& image : m_bundle.list()) {
+        if (std::find(described.begin(), described.end(), image.tag) == described.end()) {
+            releases.push_back({{"tag_name", image.tag}});
+        }
+    }
+    return releases;
+}
+
+bool DpcDownload::extractFromBundle(DpcCache& cache, const std::string& tag, DpcCache::Entry& entry) {
+    DpcBundle::Image image;
+    if (!m_bundle.find(tag, image)) {
+        std::cerr << DpcColors::error("Firmware " + tag + " is not in bundle " + m_sourceBase) << std::endl;
+        return false;
     }
     
-    return nlohmann::json::parse(r.text);
+    // Straight from the mapping: hash it, then hand it to the cache like a download
+    DpcSha256 sha;
+    sha.update(image.data, image.size);
+    if (sha.hexDigest() != image.sha256) {
+        std::cerr << DpcColors::error("Firmware " + tag + " in the bundle does not match its SHA-256") << std::endl;
+        return false;
+    }
+    if (!validateFirmwareSize(image.size) ||
+        !cache.storeData(tag, buildDownloadUrl(tag), image.data, image.size, image.sha256, entry)) {
+        std::cerr << DpcColors::error("Failed to store firmware in cache") << std::endl;
+        return false;
+    }
+    std::cout << DpcColors::ok("Firmware " + tag + " loaded from bundle (sha256 " + image.sha256.substr(0, 12) + ")")
+              << std::endl;
+    return true;
 }
 
-nlohmann::json DpcDownload::getAllReleases() {
-    std::string url = std::string(GITHUB_API_BASE) + "/releases";
+nlohmann::json DpcDownload::fetchApiJson(const std::string& path, const std::string& cacheName) {
+    return fetchApi(m_api, std::string(GITHUB_API_BASE) + path, cacheName).body;
+}
+
+DpcDownload::ApiResponse DpcDownload::fetchApi(DpcHttp& http, const std::string& url, const std::string& cacheName) {
+    DpcCache cache(m_verbose);
+    DpcCache::Metadata cached;
+    bool haveCached = cache.loadMetadata(cacheName, cached);
+    ApiResponse response;
+    
+    if (m_offline) {
+        if (!haveCached) {
+            throw std::runtime_error("No cached release information available (offline mode)");
+        }
+        if (m_verbose) {
+            std::cout << "Offline: using cached " << url << std::endl;
+        }
+        response.body = nlohmann::json::parse(cached.body);
+        response.link = cached.link;
+        return response;
+    }
     
     if (m_verbose) {
-        std::cout << "Fetching all releases from: " << url << std::endl;
+        std::cout << "Fetching release info from: " << url << std::endl;
+    }
+    
+    // Revalidate the cached copy: a 304 costs no body and does not count against the
+    // unauthenticated rate limit
+    cpr::Header headers;
+    if (haveCached && !cached.etag.empty()) {
+        headers["If-None-Match"] = cached.etag;
+    }
+    if (haveCached && !cached.lastModified.empty()) {
+        headers["If-Modified-Since"] = cached.lastModified;
     }
+    cpr::Response r = http.get(url, headers);
     
-    cpr::Response r = cpr::Get(cpr::Url{url});
+    if (r.status_code == 304 && haveCached) {
+        if (m_verbose) {
+            std::cout << "Release info not modified, using cached copy" << std::endl;
+        }
+        response.body = nlohmann::json::parse(cached.body);
+        response.link = cached.link;
+        return response;
+    }
     
-    if (r.status_code != 200) {
-        throw std::runtime_error("HTTP request failed with status: " + std::to_string(r.status_code));
+    if (r.status_code == 200) {
+        response.body = nlohmann::json::parse(r.text);
+        response.link = r.header["Link"];
+        DpcCache::Metadata fresh;
+        fresh.etag = r.header["ETag"];
+        fresh.lastModified = r.header["Last-Modified"];
+        fresh.link = response.link;
+        fresh.body = r.text;
+        cache.saveMetadata(cacheName, fresh);
+        return response;
     }
     
-    return nlohmann::json::parse(r.text);
+    // Network failure (status 0) or rate limit: the last known data beats no data
+    if (haveCached) {
+        std::cerr << DpcColors::warning(getSourceName() + " unavailable (status " + std::to_string(r.status_code) +
+                                        "), using cached release information") << std::endl;
+        response.body = nlohmann::json::parse(cached.body);
+        response.link = cached.link;
+        return response;
+    }
+    throw std::runtime_error("HTTP request failed with status: " + std::to_string(r.status_code));
 }
 
 std::string DpcDownload::buildDownloadUrl(const std::string& version) {
     std::string cleanVersion = sanitizeVersion(version);
-    return std::string(GITHUB_DOWNLOAD_BASE) + "/" + cleanVersion + "/" + FIRMWARE_FILENAME;
+    if (m_source == Source::Bundle) {
+        return m_sourceBase + "#" + cleanVersion;      // Bundle entry
+    }
+    std::string base = (m_source == Source::GitHub) ? GITHUB_DOWNLOAD_BASE : m_sourceBase;
+    return base + "/" + cleanVersion + "/" + FIRMWARE_FILENAME;
 }
 
-bool DpcDownload::downloadFile(const std::string& url, const std::string& outputPath) {
-    std::ofstream file(outputPath, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << DpcColors::error("Failed to open output file: " + outputPath) << std::endl;
-        return false;
+bool DpcDownload::downloadFile(const std::string& url, const std::string& outputPath, const std::string& expectedSha256,
+                               DownloadedFile& downloaded, bool quiet) {
+    namespace fs = std::filesystem;
+    if (url.compare(0, 7, "file://") == 0) {
+        return copyLocalFile(filePathFromUrl(url), outputPath, expectedSha256, downloaded, quiet);
     }
-    
-    // Download with progress callback
-    cpr::Response r = cpr::Get(
-        cpr::Url{url},
-        cpr::WriteCallback([&file](const std::string_view& data, intptr_t /* userdata */) {
-            file.write(data.data(), data.size());
-            return true;
-        }),
-        cpr::ProgressCallback([this](cpr::cpr_off_t downloadTotal, cpr::cpr_off_t downloadNow, 
-                                   cpr::cpr_off_t /* uploadTotal */, cpr::cpr_off_t /* uploadNow */, intptr_t /* userdata */) {
-            if (downloadTotal > 0) {
-                printProgress(downloadNow, downloadTotal);
+    std::string partPath = outputPath + ".part";
+    // ETag or Last-Modified of the response the partial file came from, for If-Range
+    std::string validatorPath = partPath + ".validator";
+    auto discardPartial = [&]() {
+        std::error_code ec;
+        fs::remove(partPath, ec);
+        fs::remove(validatorPath, ec);
+    };
+    
+    // Digest of the bytes in the partial file, updated as they arrive
+    DpcSha256 sha;
+    size_t hashedBytes = 0;
+    
+    for (int attempt = 1; attempt <= DOWNLOAD_ATTEMPTS; ++attempt) {
+        // Resume from whatever an earlier attempt (or run) left in the partial file
+        std::error_code ec;
+        size_t offset = fs::exists(partPath, ec) ? static_cast<size_t>(fs::file_size(partPath, ec)) : 0;
+        if (ec) {
+            offset = 0;
+        }
+        std::string validator;
+        if (offset > 0) {
+            std::ifstream validatorFile(validatorPath);
+            std::getline(validatorFile, validator);
+            if (validator.empty()) {
+                // Nothing tells the server which version the bytes came from: start over
+                // rather than splice a changed file onto them
+                discardPartial();
+                offset = 0;
             }
-            return true;
-        })
-    );
-    
-    file.close();
+        }
+        if (offset != hashedBytes) {
+            // Left over from an earlier run: its bytes are read once to seed the digest
+            sha.reset();
+            hashedBytes = 0;
+            if (sha.updateFile(partPath)) {
+                hashedBytes = offset;
+            } else {
+                offset = 0;
+            }
+        }
+        cpr::Header headers;
+        if (offset > 0) {
+            headers["Range"] = "bytes=" + std::to_string(offset) + "-";
+            headers["If-Range"] = validator;    // Whole file (200) if it changed since
+            std::cout << "Resuming download at " << offset << " bytes" << std::endl;
+        }
+        
+        long status = 0;                // Of the last response; redirects come first
+        size_t expectedSize = 0;        // Whole file, 0 if the server does not say
+        std::string etag;
+        std::string lastModified;
+        std::FILE* file = nullptr;
+        bool writeFailed = false;
+        DpcProgress progress;           // Drawn from its own thread, never from libcurl's
+        
+        cpr::Response r = m_files.download(
+            url,
+            headers,
+            cpr::HeaderCallback([&](const std::string_view& line, intptr_t /* userdata */) {
+                std::string value;
+                if (line.substr(0, 5) == "HTTP/") {
+                    size_t space = line.find(' ');
+                    status = (space == std::string_view::npos) ? 0 : std::atol(std::string(line.substr(space + 1)).c_str());
+                    expectedSize = 0;
+                    etag.clear();
+                    lastModified.clear();
+                } else if (status == 206 && headerValue(line, "Content-Range", value)) {
+                    // "bytes 1000-57435/57436"
+                    size_t slash = value.rfind('/');
+                    expectedSize = (slash == std::string::npos) ? 0 : std::strtoull(value.c_str() + slash + 1, nullptr, 10);
+                } else if (status == 200 && headerValue(line, "Content-Length", value)) {
+                    expectedSize = std::strtoull(value.c_str(), nullptr, 10);
+                } else if (headerValue(line, "ETag", value)) {
+                    etag = value;
+                } else if (headerValue(line, "Last-Modified", value)) {
+                    lastModified = value;
+                }
+                return true;
+            }),
+            cpr::WriteCallback([&](const std::string_view& data, intptr_t /* userdata */) {
+                if (status != 200 && status != 206) {
+                    return true;        // Body of an error response
+                }
+                if (!file) {
+                    // A 200 answer to a range request is the whole file again
+                    bool append = (status == 206 && offset > 0);
+                    if (!append) {
+                        offset = 0;
+                        sha.reset();
+                        hashedBytes = 0;
+                        // If-Range takes only strong ETags
+                        std::string newValidator = (!etag.empty() && etag.compare(0, 2, "W/") != 0) ? etag : lastModified;
+                        std::error_code ec;
+                        fs::remove(validatorPath, ec);
+                        if (!newValidator.empty()) {
+                            std::ofstream(validatorPath, std::ios::trunc) << newValidator << std::endl;
+                        }
+                    }
+                    file = std::fopen(partPath.c_str(), append ? "ab" : "wb");
+                    if (!file) {
+                        writeFailed = true;
+                        return false;
+                    }
+                }
+                if (std::fwrite(data.data(), 1, data.size(), file) != data.size()) {
+                    writeFailed = true;
+                    return false;
+                }
+                sha.update(data.data(), data.size());
+                hashedBytes += data.size();
+                return true;
+            }),
+            cpr::ProgressCallback([&](cpr::cpr_off_t downloadTotal, cpr::cpr_off_t downloadNow,
+                                      cpr::cpr_off_t /* uploadTotal */, cpr::cpr_off_t /* uploadNow */, intptr_t /* userdata */) {
+                if (downloadTotal > 0 && (status == 200 || status == 206)) {
+                    progress.update("download", static_cast<size_t>(offset + downloadNow),
+                                    static_cast<size_t>(offset + downloadTotal));
+                }
+                return true;
+            })
+        );
+        
+        bool synced = file && DpcCache::syncFile(file);
+        if (file) {
+            std::fclose(file);
+        }
+        progress.finish();
+        
+        if (writeFailed) {
+            std::cerr << DpcColors::error("Failed to write download file: " + partPath) << std::endl;
+            return false;
+        }
+        if (r.status_code == 416) {
+            // Range beyond the file: the partial file is stale, start over
+            discardPartial();
+            sha.reset();
+            hashedBytes = 0;
+            continue;
+        }
+        if (r.error || r.status_code == 0 || r.status_code >= 500) {
+            // Transient failure: keep the partial file and resume after a short pause
+            std::cerr << DpcColors::warning("Download interrupted (" +
+                                            (r.error ? r.error.message : "status " + std::to_string(r.status_code)) +
+                                            "), attempt " + std::to_string(attempt) + " of " +
+                                            std::to_string(DOWNLOAD_ATTEMPTS)) << std::endl;
+            if (attempt < DOWNLOAD_ATTEMPTS) {
+                std::this_thread::sleep_for(RETRY_DELAY * attempt);
+            }
+            continue;
+        }
+        if (r.status_code != 200 && r.status_code != 206) {
+            if (!quiet) {
+                std::cerr << DpcColors::error("HTTP request failed with status: " + std::to_string(r.status_code)) << std::endl;
+                if (r.status_code == 404) {
+                    std::cerr << "The requested firmware version was not found." << std::endl;
+                }
+            }
+            discardPartial();
+            return false;
+        }
+        if (!synced) {
+            std::cerr << DpcColors::error("Failed to flush download file: " + partPath) << std::endl;
+            return false;
+        }
+        
+        if (expectedSize > 0 && hashedBytes != expectedSize) {
+            if (hashedBytes < expectedSize) {
+                continue;               // Short read without an error: resume
+            }
+            std::cerr << DpcColors::error("Downloaded file has the wrong size (" + std::to_string(hashedBytes) +
+                                          " of " + std::to_string(expectedSize) + " bytes)") << std::endl;
+            discardPartial();
+            return false;
+        }
+        downloaded.size = hashedBytes;
+        downloaded.sha256 = sha.hexDigest();
+        if (!expectedSha256.empty() && downloaded.sha256 != expectedSha256) {
+            std::cerr << DpcColors::error("Downloaded file does not match the published SHA-256") << std::endl;
+            discardPartial();
+            return false;
+        }
+        
+        // Only a complete, checked file ever appears under the final name
+        fs::rename(partPath, outputPath, ec);
+        if (ec) {
+            std::cerr << DpcColors::error("Failed to move download into place: " + ec.message()) << std::endl;
+            return false;
+        }
+        fs::remove(validatorPath, ec);
+        return true;
+    }
     
-    if (r.status_code != 200) {
-        std::cerr << std::endl << DpcColors::error("HTTP request failed with status: " + std::to_string(r.status_code)) << std::endl;
-        if (r.status_code == 404) {
-            std::cerr << "The requested firmware version was not found." << std::endl;
+    std::cerr << DpcColors::error("Download failed after " + std::to_string(DOWNLOAD_ATTEMPTS) + " attempts") << std::endl;
+    return false;
+}
+
+bool DpcDownload::copyLocalFile(const std::string& path, const std::string& outputPath, const std::string& expectedSha256,
+                                DownloadedFile& copied, bool quiet) {
+    // Same guarantees as a download: hashed in one pass, synced, renamed into place
+    std::string partPath = outputPath + ".part";
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) {
+        if (!quiet) {
+            std::cerr << DpcColors::error("Firmware not found in mirror: " + path) << std::endl;
         }
-        // Clean up partial download
-        std::filesystem::remove(outputPath);
+        return false;
+    }
+    std::FILE* out = std::fopen(partPath.c_str(), "wb");
+    if (!out) {
+        std::fclose(in);
+        std::cerr << DpcColors::error("Failed to write download file: " + partPath) << std::endl;
         return false;
     }
     
-    std::cout << std::endl; // New line after progress
+    DpcSha256 sha;
+    copied.size = 0;
+    char buffer[16384];
+    bool ok = true;
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        if (std::fwrite(buffer, 1, count, out) != count) {
+            ok = false;
+            break;
+        }
+        sha.update(buffer, count);
+        copied.size += count;
+    }
+    ok = ok && !std::ferror(in) && DpcCache::syncFile(out);
+    std::fclose(in);
+    std::fclose(out);
+    copied.sha256 = sha.hexDigest();
+    
+    std::error_code ec;
+    if (!ok || (!expectedSha256.empty() && copied.sha256 != expectedSha256)) {
+        std::cerr << DpcColors::error(ok ? "Mirror file does not match the published SHA-256" : "Failed to copy " + path)
+                  << std::endl;
+        std::filesystem::remove(partPath, ec);
+        return false;
+    }
+    std::filesystem::rename(partPath, outputPath, ec);
+    if (ec) {
+        std::cerr << DpcColors::error("Failed to move download into place: " + ec.message()) << std::endl;
+        return false;
+    }
     return true;
 }
 
-bool DpcDownload::validateFirmwareFile(const std::string& filePath) {
-    if (!fileExists(filePath)) {
-        if (m_verbose) {
-            std::cerr << "Firmware file not found: " << filePath << std::endl;
+std::string DpcDownload::filePathFromUrl(const std::string& url) {
+    std::string path = url.substr(url.compare(0, 7, "file://") == 0 ? 7 : 0);
+    // file:///C:/firmware -> C:/firmware
+    if (path.size() >= 3 && path[0] == '/' && path[2] == ':') {
+        path.erase(0, 1);
+    }
+    return path;
+}
+
+nlohmann::json DpcDownload::findCachedRelease(const std::string& tag) {
+    if (m_source != Source::GitHub) {
+        // The mirror index is small and revalidated (or local): look it up directly
+        try {
+            for (const auto& release : getSourceReleases()) {
+                if (release.value("tag_name", "") == tag) {
+                    return release;
+                }
+            }
+        } catch (const std::exception& e) {
+            if (m_verbose) {
+                std::cerr << "Cannot read release list: " << e.what() << std::endl;
+            }
         }
-        return false;
+        return nlohmann::json();
     }
     
-    // Check file size - firmware should be reasonably large (> 1KB)
-    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        if (m_verbose) {
-            std::cerr << "Cannot open firmware file: " << filePath << std::endl;
+    // Use whatever release information is already cached rather than asking the API again
+    // (the latest release, then the release list page by page)
+    DpcCache cache(m_verbose);
+    for (size_t page = 0;; ++page) {
+        std::string name = (page == 0) ? "releases-latest" : (page == 1) ? "releases" : "releases-page-" + std::to_string(page);
+        DpcCache::Metadata metadata;
+        if (!cache.loadMetadata(name, metadata)) {
+            if (page == 0) {
+                continue;
+            }
+            break;
+        }
+        nlohmann::json releases = nlohmann::json::parse(metadata.body, nullptr, false);
+        if (releases.is_object()) {
+            releases = nlohmann::json::array({releases});
+        }
+        if (!releases.is_array()) {
+            continue;
         }
+        for (const auto& release : releases) {
+            if (release.value("tag_name", "") == tag) {
+                return release;
+            }
+        }
+    }
+    return nlohmann::json();
+}
+
+std::string DpcDownload::findPublishedDigest(const nlohmann::json& release) {
+    // GitHub lists a "sha256:<hex>" digest per release asset
+    if (!release.contains("assets")) {
+        return "";
+    }
+    for (const auto& asset : release["assets"]) {
+        std::string digest = asset.value("digest", "");
+        if (asset.value("name", "") == FIRMWARE_FILENAME && digest.compare(0, 7, "sha256:") == 0) {
+            return digest.substr(7);
+        }
+    }
+    return "";
+}
+
+bool DpcDownload::fetchDelta(DpcCache& cache, const nlohmann::json& release, const std::string& tag,
+                             const std::string& expectedSha256, DpcCache::Entry& entry) {
+    if (!release.contains("assets")) {
         return false;
     }
     
-    std::streamsize size = file.tellg();
-    file.close();
-    
+    // Delta assets are named "firmware-<base tag>.delta"; use the first whose base is cached
+    const std::string prefix = DELTA_PREFIX;
+    const std::string suffix = DELTA_SUFFIX;
+    for (const auto& asset : release["assets"]) {
+        std::string name = asset.value("name", "");
+        std::string url = asset.value("browser_download_url", "");
+        if (url.empty() || name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        std::string baseTag = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        DpcCache::Entry base;
+        if (baseTag == tag || !cache.lookup(baseTag, base)) {
+            continue;
+        }
+        
+        std::cout << "Downloading delta against cached " << baseTag << "..." << std::endl;
+        std::string patchPath = cache.getTempPath(url);
+        DownloadedFile downloaded;
+        if (!downloadFile(url, patchPath, "", downloaded, true)) {
+            std::cerr << DpcColors::warning("Delta download failed, downloading the full image") << std::endl;
+            return false;
+        }
+        
+        // apply() checks the base digest and the patched image against the digest in the patch
+        std::vector<uint8_t> baseImage;
+        std::vector<uint8_t> patch;
+        std::vector<uint8_t> image;
+        std::string error = "cannot read " + patchPath;
+        bool patched = DpcDelta::loadFile(base.path, baseImage) && DpcDelta::loadFile(patchPath, patch) &&
+                       DpcDelta::apply(baseImage, patch, image, error);
+        removeFile(patchPath);
+        std::string sha256 = DpcDelta::getTargetDigest(patch);
+        if (patched && !expectedSha256.empty() && sha256 != expectedSha256) {
+            patched = false;
+            error = "patched image does not match the published SHA-256";
+        }
+        if (!patched || !validateFirmwareSize(image.size())) {
+            std::cerr << DpcColors::warning("Delta from " + baseTag + " not usable (" + error +
+                                            "), downloading the full image") << std::endl;
+            return false;
+        }
+        
+        // Stored from memory: written, synced and renamed into place by the cache
+        if (!cache.storeData(tag, buildDownloadUrl(tag), image.data(), image.size(), sha256, entry)) {
+            return false;
+        }
+        std::cout << DpcColors::ok("Firmware patched from " + baseTag + " (" + std::to_string(downloaded.size) + " of " +
+                                   std::to_string(image.size()) + " bytes downloaded, sha256 " +
+                                   sha256.substr(0, 12) + ")") << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool DpcDownload::validateFirmwareSize(size_t size) {
     if (size < 1024) { // Less than 1KB seems too small for firmware
         if (m_verbose) {
             std::cerr << "Firmware file seems too small: " << size << " bytes" << std::endl;
@@ -237,27 +916,6 @@ bool DpcDownload::validateFirmwareFile(const std::string& filePath) {
     return true;
 }
 
-std::string DpcDownload::backupExistingFile(const std::string& filePath) {
-    if (!fileExists(filePath)) {
-        return ""; // Nothing to backup
-    }
-    
-    std::string backupPath = filePath + ".backup." + getCurrentTimestamp();
-    
-    try {
-        std::filesystem::copy_file(filePath, backupPath);
-        if (m_verbose) {
-            std::cout << "Backed up existing file to: " << backupPath << std::endl;
-        }
-        return backupPath;
-    } catch (const std::exception& e) {
-        if (m_verbose) {
-            std::cerr << "Failed to backup file: " << e.what() << std::endl;
-        }
-        return "";
-    }
-}
-
 bool DpcDownload::promptOverwriteExisting(const std::string& filePath) {
     std::cout << "Existing firmware found: " << filePath << std::endl;
     std::cout << "Download new version? (Y/n): ";
@@ -283,31 +941,6 @@ bool DpcDownload::fileExists(const std::string& path) {
     return file.good();
 }
 
-std::string DpcDownload::getCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y%m%d_%H%M%S");
-    return ss.str();
-}
-
-void DpcDownload::printProgress(size_t downloaded, size_t total) {
-    if (total == 0) return;
-    
-    int progress = (downloaded * 100) / total;
-    int barWidth = 50;
-    int pos = (downloaded * barWidth) / total;
-    
-    std::cout << "\r[";
-    for (int i = 0; i < barWidth; ++i) {
-        if (i < pos) std::cout << "=";
-        else if (i == pos) std::cout << ">";
-        else std::cout << " ";
-    }
-    std::cout << "] " << progress << "% (" << downloaded << "/" << total << " bytes)" << std::flush;
-}
-
 bool DpcDownload::isValidVersion(const std::string& version) {
     if (version.empty()) return false;
     if (version == "latest") return true;
@@ -321,60 +954,6 @@ std::string DpcDownload::sanitizeVersion(const std::string& version) {
     return version;
 }
 
-bool DpcDownload::filesAreIdentical(const std::string& file1, const std::string& file2) {
-    if (!fileExists(file1) || !fileExists(file2)) {
-        return false;
-    }
-    
-    // Compare file sizes first (quick check)
-    std::ifstream f1(file1, std::ios::binary | std::ios::ate);
-    std::ifstream f2(file2, std::ios::binary | std::ios::ate);
-    
-    if (!f1.is_open() || !f2.is_open()) {
-        return false;
-    }
-    
-    auto size1 = f1.tellg();
-    auto size2 = f2.tellg();
-    
-    if (size1 != size2) {
-        return false;
-    }
-    
-    // If sizes match, compare content
-    f1.seekg(0);
-    f2.seekg(0);
-    
-    const size_t bufferSize = 4096;
-    char buffer1[bufferSize];
-    char buffer2[bufferSize];
-    
-    while (true) {
-        f1.read(buffer1, bufferSize);
-        f2.read(buffer2, bufferSize);
-        
-        std::streamsize bytesRead1 = f1.gcount();
-        std::streamsize bytesRead2 = f2.gcount();
-        
-        // If different amounts were read, files are different
-        if (bytesRead1 != bytesRead2) {
-            return false;
-        }
-        
-        // If no bytes were read, we've reached the end of both files
-        if (bytesRead1 == 0) {
-            break;
-        }
-        
-        // Compare the content that was read
-        if (std::memcmp(buffer1, buffer2, bytesRead1) != 0) {
-            return false;
-        }
-    }
-    
-    return true;
-}
-
 bool DpcDownload::removeFile(const std::string& filePath) {
     try {
         std::filesystem::remove(filePath);
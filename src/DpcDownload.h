@@ -3,33 +3,68 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <chrono>
 #include <nlohmann/json.hpp>
+#include "DpcCache.h"
+#include "DpcHttp.h"
+#include "DpcBundle.h"
 
 class DpcDownload {
 public:
     // Constructor
     DpcDownload(bool verbose = false);
     
+    // Offline mode: release information and firmware only from the local cache
+    void setOffline(bool offline);
+    
+    // Where releases come from: the GitHub API, a firmware bundle file (DpcBundle), or a
+    // mirror (a local directory or an HTTP server) with the layout
+    //   releases.json                  release list, newest first, in GitHub API format;
+    //                                  asset URLs may be omitted or relative
+    //   <tag>/firmware.bin             and optionally <tag>/firmware-<base tag>.delta
+    enum class Source { GitHub, FileMirror, HttpMirror, Bundle };
+    
+    // "github", a bundle file, a directory or file:// URL, or an http(s):// URL; false if
+    // not usable
+    bool setSource(const std::string& spec);
+    std::string getSourceName() const;
+    
     // Main download functionality, returns the path to the downloaded firmware file
     std::string downloadFirmware(const std::string& version = "latest", 
                                 const std::string& customUrl = "",
                                 const std::string& outputPath = "");
     
+    // Resolve a firmware image through the local cache (see DpcCache), downloading it
+    // only when the release is not cached yet; returns the path of the cached image
+    std::string fetchFirmware(const std::string& version = "latest", const std::string& customUrl = "");
+    
     // Utility methods
     bool checkExistingFirmware(const std::string& outputPath = "");
     std::string getLatestVersionTag();
     std::vector<std::string> getAvailableVersions();
     
-    // GitHub API methods
+    // Release information from the source. HTTP responses are cached with their
+    // ETag/Last-Modified and revalidated, and served from the cache when offline or when
+    // the server is unavailable.
     nlohmann::json getLatestRelease();
     nlohmann::json getAllReleases();
     std::string buildDownloadUrl(const std::string& version);
     
     // File operations
-    bool downloadFile(const std::string& url, const std::string& outputPath);
-    bool validateFirmwareFile(const std::string& filePath);
-    std::string backupExistingFile(const std::string& filePath);
-    bool filesAreIdentical(const std::string& file1, const std::string& file2);
+    // Size and SHA-256 of a download, computed while the bytes arrive
+    struct DownloadedFile {
+        size_t size = 0;
+        std::string sha256;
+    };
+    
+    // Downloads into outputPath + ".part", resuming it with a Range request after an
+    // interruption; the file is synced and renamed to outputPath only once its size (and
+    // SHA-256, if expected) checks out. With quiet, HTTP errors are left to the caller
+    // (for optional files such as deltas).
+    bool downloadFile(const std::string& url, const std::string& outputPath, const std::string& expectedSha256,
+                      DownloadedFile& downloaded, bool quiet = false);
+    bool validateFirmwareSize(size_t size);
     bool removeFile(const std::string& filePath);
     
     // User interaction
@@ -37,18 +72,52 @@ public:
     
 private:
     bool m_verbose;
+    bool m_offline;
+    Source m_source;
+    std::string m_sourceBase;       // Mirror URL (file:// for a directory) or bundle path
+    DpcBundle m_bundle;             // Mapped while the bundle is the source
+    // API and file downloads go to different hosts: one keep-alive connection each
+    DpcHttp m_api;
+    DpcHttp m_files;
+    
+    // Parsed API response; link is the pagination Link header
+    struct ApiResponse {
+        nlohmann::json body;
+        std::string link;
+    };
     
     // Constants
     static constexpr const char* GITHUB_API_BASE = "https://api.github.com/repos/diyPresso/diyPresso-One";
     static constexpr const char* GITHUB_DOWNLOAD_BASE = "https://github.com/diyPresso/diyPresso-One/releases/download";
     static constexpr const char* FIRMWARE_FILENAME = "firmware.bin";
+    static constexpr const char* MIRROR_INDEX = "releases.json";
     static constexpr const char* DEFAULT_OUTPUT_PATH = "firmware.bin";
+    static constexpr const char* DELTA_PREFIX = "firmware-";     // Delta assets: firmware-<base tag>.delta
+    static constexpr const char* DELTA_SUFFIX = ".delta";
+    static constexpr int DOWNLOAD_ATTEMPTS = 5;
+    static constexpr size_t RELEASES_PER_PAGE = 100;                 // GitHub's maximum
+    static constexpr size_t MAX_PAGE_CONNECTIONS = 4;
+    static constexpr std::chrono::seconds RETRY_DELAY{1};        // Times the attempt number
     
     // Helper methods
+    nlohmann::json fetchApiJson(const std::string& path, const std::string& cacheName);
+    ApiResponse fetchApi(DpcHttp& http, const std::string& url, const std::string& cacheName);
+    static std::map<std::string, std::string> parseLinkHeader(const std::string& header);  // rel -> URL
+    static size_t getPageNumber(const std::string& url);
+    static std::string setPageNumber(const std::string& url, size_t page);
+    nlohmann::json getSourceReleases();             // Release list of a mirror or bundle
+    nlohmann::json getBundleReleases();
+    bool extractFromBundle(DpcCache& cache, const std::string& tag, DpcCache::Entry& entry);
+    bool copyLocalFile(const std::string& path, const std::string& outputPath, const std::string& expectedSha256,
+                       DownloadedFile& copied, bool quiet);
+    static std::string filePathFromUrl(const std::string& url);
+    nlohmann::json findCachedRelease(const std::string& tag);       // Null if not cached
+    std::string findPublishedDigest(const nlohmann::json& release); // Empty if unknown
+    // Fetch the release as a delta (DpcDelta) against a cached image, if it offers one
+    bool fetchDelta(DpcCache& cache, const nlohmann::json& release, const std::string& tag,
+                    const std::string& expectedSha256, DpcCache::Entry& entry);
     std::string getDefaultOutputPath();
     bool fileExists(const std::string& path);
-    std::string getCurrentTimestamp();
-    void printProgress(size_t downloaded, size_t total);
     bool isValidVersion(const std::string& version);
     std::string sanitizeVersion(const std::string& version);
 }; 
\ No newline at end of file
@@ -3,13 +3,16 @@
 #include "DpcDevice.h"
 #include "DpcDownload.h"
 #include "DpcColors.h"
+#include "DpcTaskGraph.h"
+#include "DpcBossac.h"
+#include "DpcProgress.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <cstdlib>
-#include <thread>
 #include <chrono>
 #include <algorithm>
+#include <vector>
 
 
 #ifdef _WIN32
@@ -20,73 +23,184 @@
 #include <sys/stat.h>
 #endif
 
-DpcFirmware::DpcFirmware(bool verbose) : m_verbose(verbose) {
+DpcFirmware::DpcFirmware(bool verbose)
+    : m_verbose(verbose), m_showProgress(true), m_offline(false), m_flasher(Flasher::Native) {
+}
+
+void DpcFirmware::setFlasher(Flasher flasher, const DpcFlasher::Options& flashOptions) {
+    m_flasher = flasher;
+    m_flashOptions = flashOptions;
+}
+
+void DpcFirmware::setShowProgress(bool showProgress) {
+    m_showProgress = showProgress;
+}
+
+void DpcFirmware::setOffline(bool offline) {
+    m_offline = offline;
+}
+
+void DpcFirmware::setSource(const std::string& source) {
+    m_source = source;
 }
 
 bool DpcFirmware::uploadFirmware(DpcDevice* device, const std::string& firmwarePath, const std::string& bossacPath, 
                                 const std::string& version, const std::string& binaryUrl) {
     std::cout << DpcColors::highlight("=== diyPresso Firmware Upload ===") << std::endl;
     
-    // Step 0.1: Prepare settings manager and backup filename
-    DpcSettings settingsManager;
-    std::string backupFilename;
-    bool skip_settings = false;
+    // Step 3.1: Validate device pointer
+    if (!device) {
+        std::cerr << DpcColors::error("No device provided") << std::endl;
+        return false;
+    }
+    
+    UploadPlan plan;
+    plan.flasher = m_flasher;
+    plan.flashOptions = m_flashOptions;
+    DeviceUpload upload;
+    
+    // Ask before anything runs in parallel: the question cannot share the console
+    if (device->is_in_bootloader_mode() && !backupSettings(*device, upload, true)) {
+        return false;
+    }
+    
+    // Steps as a dependency graph: the download overlaps the settings backup, and the
+    // reset waits for both, so a failed download never leaves the device in the bootloader
+    DpcTaskGraph graph;
+    auto download = graph.addTask("download", [&]() {
+        return resolveFirmware(plan, firmwarePath, version, binaryUrl);
+    });
+    auto flasherCheck = graph.addTask("check flasher", [&]() {
+        return checkFlasher(plan, bossacPath);
+    });
+    auto fileCheck = graph.addTask("check file", [&]() {
+        return checkFirmware(plan);
+    }, {download});
+    auto backup = graph.addTask("backup", [&]() {
+        std::cout << std::endl << DpcColors::step("Step 4/7: Retrieving and backing up current settings...") << std::endl;
+        return upload.skipSettings || backupSettings(*device, upload, false);
+    });
+    auto reset = graph.addTask("reset", [&]() {
+        std::cout << std::endl << DpcColors::step("Step 5/7: Putting device in bootloader mode...") << std::endl;
+        return enterBootloader(*device, upload);
+    }, {backup, fileCheck, flasherCheck});
+    auto flash = graph.addTask("flash", [&]() {
+        std::cout << std::endl << DpcColors::step("Step 6/7: Uploading firmware...") << std::endl;
+        return flashFirmware(plan, upload);
+    }, {reset});
+    graph.addTask("restore", [&]() {
+        std::cout << std::endl << DpcColors::step("Step 7/7: Waiting for device reboot and restoring settings...") << std::endl;
+        restoreSettings(*device, upload);
+        return true;
+    }, {flash});
+    
+    bool completed = graph.run();
+    std::cout << std::endl;
+    graph.printCriticalPath(std::cout);
+    if (!completed) {
+        return false;
+    }
     
+    std::cout << std::endl;
+    if (upload.settingsRestored) {
+        std::cout << DpcColors::ok("Firmware upload completed successfully and device settings restored!") << std::endl;
+    } else {
+        std::cout << DpcColors::warning("Firmware upload completed successfully, device settings NOT restored.") << std::endl;
+        if (!upload.skipSettings) {
+            std::cout << "Use the settings backup file for restoration with the restore-settings command if desired." << std::endl;
+        }
+    }
+    
+    return true;
+}
+
+bool DpcFirmware::prepareUpload(UploadPlan& plan, const std::string& firmwarePath, const std::string& bossacPath,
+                                const std::string& version, const std::string& binaryUrl) {
+    return resolveFirmware(plan, firmwarePath, version, binaryUrl) && checkFlasher(plan, bossacPath) &&
+           checkFirmware(plan);
+}
+
+bool DpcFirmware::resolveFirmware(UploadPlan& plan, const std::string& firmwarePath, const std::string& version,
+                                  const std::string& binaryUrl) {
     // Step 0.2: Download firmware if no binary file provided
-    std::string finalFirmwarePath;
     if (firmwarePath.empty()) {
         std::cout << std::endl << DpcColors::step("Step 1/7: Downloading firmware...") << std::endl;
         
         // Create download manager
         DpcDownload downloader(m_verbose);
+        downloader.setOffline(m_offline);
+        if (!downloader.setSource(m_source)) {
+            return false;
+        }
         
-        // Download to default location
-        finalFirmwarePath = downloader.downloadFirmware(version, binaryUrl, "");
-        if (finalFirmwarePath.empty()) {
+        // Cached releases are used in place, without a download
+        plan.firmwarePath = downloader.fetchFirmware(version, binaryUrl);
+        if (plan.firmwarePath.empty()) {
             std::cerr << DpcColors::error("Firmware download failed!") << std::endl;
             return false;
         }
     } else {
-        finalFirmwarePath = firmwarePath;
+        plan.firmwarePath = firmwarePath;
     }
     
-    // Step 0.3: Determine bossac path
-    std::string finalBossacPath = bossacPath.empty() ? getBossacPath() : bossacPath;
-    
     if (m_verbose) {
-        std::cout << "Firmware path: " << finalFirmwarePath << std::endl;
-        std::cout << "Bossac path: " << finalBossacPath << std::endl;
+        std::cout << "Firmware path: " << plan.firmwarePath << std::endl;
     }
-    
-    // Step 1.1: Print and check bossac executable
-    std::cout << std::endl << DpcColors::step("Step 2/7: Checking bossac executable...") << std::endl;
-    if (!checkBossacExecutable(finalBossacPath)) {
-        std::cerr << DpcColors::error("bossac executable not found or not accessible at: " + finalBossacPath) << std::endl;
-        return false;
+    return true;
+}
+
+bool DpcFirmware::checkFlasher(UploadPlan& plan, const std::string& bossacPath) {
+    if (plan.flasher == Flasher::Bossac) {
+        // Step 0.3: Determine bossac path
+        plan.bossacPath = bossacPath.empty() ? getBossacPath() : bossacPath;
+        if (m_verbose) {
+            std::cout << "Bossac path: " << plan.bossacPath << std::endl;
+        }
+        
+        // Step 1.1: Print and check bossac executable
+        std::cout << std::endl << DpcColors::step("Step 2/7: Checking bossac executable...") << std::endl;
+        if (!checkBossacExecutable(plan.bossacPath)) {
+            std::cerr << DpcColors::error("bossac executable not found or not accessible at: " + plan.bossacPath) << std::endl;
+            return false;
+        }
+        std::cout << DpcColors::ok("bossac executable found and accessible") << std::endl;
+    } else {
+        std::cout << std::endl << DpcColors::step("Step 2/7: Checking flasher...") << std::endl;
+        size_t blockSize = plan.flashOptions.block_size;
+        if (blockSize == 0 || blockSize > DpcFlasher::MAX_BLOCK_SIZE || blockSize % DpcFlasher::PAGE_SIZE != 0) {
+            std::cerr << DpcColors::error("Flash block size must be a multiple of " + std::to_string(DpcFlasher::PAGE_SIZE) +
+                                          " bytes up to " + std::to_string(DpcFlasher::MAX_BLOCK_SIZE)) << std::endl;
+            return false;
+        }
+        std::cout << DpcColors::ok("Using built-in SAM-BA flasher (" + std::to_string(blockSize) + " byte blocks" +
+                                   (plan.flashOptions.delta ? ", changed rows only)" : ", full erase)")) << std::endl;
     }
-    std::cout << DpcColors::ok("bossac executable found and accessible") << std::endl;
-    
+    return true;
+}
+
+bool DpcFirmware::checkFirmware(const UploadPlan& plan) {
     // Step 2.1: Print and check firmware file
     std::cout << std::endl << DpcColors::step("Step 3/7: Checking firmware file...") << std::endl;
-    if (!checkFirmwareFile(finalFirmwarePath)) {
-        std::cerr << DpcColors::error("Firmware file not found at: " + finalFirmwarePath) << std::endl;
-        return false;
-    }
-    std::cout << DpcColors::ok("Firmware file found: " + finalFirmwarePath) << std::endl;
-    
-    std::cout << std::endl << DpcColors::step("Step 4/7: Retrieving and backing up current settings...") << std::endl;
-    
-    // Step 3.1: Validate device pointer
-    if (!device) {
-        std::cerr << DpcColors::error("No device provided") << std::endl;
+    if (!checkFirmwareFile(plan.firmwarePath)) {
+        std::cerr << DpcColors::error("Firmware file not found at: " + plan.firmwarePath) << std::endl;
         return false;
     }
+    std::cout << DpcColors::ok("Firmware file found: " + plan.firmwarePath) << std::endl;
     
+    return true;
+}
+
+bool DpcFirmware::backupSettings(DpcDevice& device, DeviceUpload& upload, bool interactive) {
     // Step 3.2: Check if device is in bootloader mode
-    if (device->is_in_bootloader_mode()) {
+    if (device.is_in_bootloader_mode()) {
         std::cout << DpcColors::warning("Device is already in bootloader mode. Settings cannot be retrieved and restored.") << std::endl;
-        std::cout << std::endl;
         
+        if (!interactive) {
+            upload.skipSettings = true;
+            return true;
+        }
+        
+        std::cout << std::endl;
         std::string choice;
         std::cout << "Do you want to continue firmware upload without settings backup and restore? (y/N): ";
         std::getline(std::cin, choice);
@@ -95,29 +209,28 @@ bool DpcFirmware::uploadFirmware(DpcDevice* device, const std::string& firmwareP
         std::transform(choice.begin(), choice.end(), choice.begin(), ::tolower);
         
         if (choice == "y" || choice == "yes") {
-            skip_settings = true;
+            upload.skipSettings = true;
             std::cout << DpcColors::warning("Proceeding without settings backup/restore...") << std::endl;
-        } else {
-            std::cout << "Firmware upload cancelled." << std::endl;
-            std::cout << "Please restart the device to normal mode and try again." << std::endl;
-            return false;
+            return true;
         }
+        std::cout << "Firmware upload cancelled." << std::endl;
+        std::cout << "Please restart the device to normal mode and try again." << std::endl;
+        return false;
     }
     
-    // Step 3.4: Retrieve settings and save as backup (only if not skipping)
-    if (!skip_settings) {
-        if (!settingsManager.backup_current_settings(*device, backupFilename)) {
-            std::cerr << DpcColors::error("Failed to backup current settings") << std::endl;
-            return false;
-        }
-        std::cout << DpcColors::ok("Settings backed up to: " + backupFilename) << std::endl;
+    // Step 3.4: Retrieve settings and save as backup
+    DpcSettings settingsManager;
+    if (!settingsManager.backup_current_settings(device, upload.backupFilename)) {
+        std::cerr << DpcColors::error("Failed to backup current settings") << std::endl;
+        return false;
     }
-    
-    // Step 4: Put device in bootloader mode
-    std::cout << std::endl << DpcColors::step("Step 5/7: Putting device in bootloader mode...") << std::endl;
-    
-    if (!device->is_in_bootloader_mode()) {
-        if (!device->reset_to_bootloader()) {
+    std::cout << DpcColors::ok("Settings backed up to: " + upload.backupFilename) << std::endl;
+    return true;
+}
+
+bool DpcFirmware::enterBootloader(DpcDevice& device, DeviceUpload& upload) {
+    if (!device.is_in_bootloader_mode()) {
+        if (!device.reset_to_bootloader()) {
             std::cerr << DpcColors::error("Failed to reset device into bootloader mode") << std::endl;
             return false;
         }
@@ -125,25 +238,91 @@ bool DpcFirmware::uploadFirmware(DpcDevice* device, const std::string& firmwareP
     } else {
         std::cout << DpcColors::ok("Device already in bootloader mode") << std::endl;
     }
-    std::string port = device->get_port();
+    upload.bootloaderPort = device.get_port();
     if (m_verbose) {
-        std::cout << "  New port: " << port << std::endl;
+        std::cout << "  New port: " << upload.bootloaderPort << std::endl;
     }
     
     // Disconnect from the device to release the COM port
     std::cout << "Releasing COM port for bossac access..." << std::endl;
-    device->disconnect();
+    device.disconnect();
+    return true;
+}
+
+bool DpcFirmware::flashFirmware(const UploadPlan& plan, DeviceUpload& upload) {
+    std::cout << "Using bootloader port for firmware upload: " << upload.bootloaderPort << std::endl;
+    return plan.flasher == Flasher::Bossac ? flashWithBossac(plan, upload) : flashNative(plan, upload);
+}
+
+bool DpcFirmware::flashNative(const UploadPlan& plan, DeviceUpload& upload) {
+    std::vector<uint8_t> image;
+    if (!DpcFlasher::load_image(plan.firmwarePath, image)) {
+        std::cerr << DpcColors::error("Cannot read firmware file: " + plan.firmwarePath) << std::endl;
+        return false;
+    }
     
-    // Step 5: Upload firmware (build and execute bossac command)
-    std::cout << std::endl << DpcColors::step("Step 6/7: Uploading firmware...") << std::endl;
+    // The flasher retries the bootloader handshake, so no settling delay is needed here
+    std::cout << "Uploading firmware to device..." << std::endl;
+    DpcFlasher flasher(m_verbose);
+    DpcProgress progress;
+    DpcFlasher::ProgressCallback onProgress = [&progress](const std::string& phase, size_t done, size_t total) {
+        progress.update(phase, done, total);
+    };
+    bool flashed = flasher.flash(upload.bootloaderPort, image, plan.flashOptions,
+                                 m_showProgress ? onProgress : nullptr);
+    progress.finish();
+    upload.flashTimings = flasher.get_timings();
+    upload.flashReport = flasher.get_report();
+    
+    if (m_verbose || !flashed) {
+        std::cout << "Flash timings:" << std::endl;
+        flasher.get_timings().print(std::cout);
+    }
+    if (!flashed) {
+        std::cerr << DpcColors::error("Firmware upload failed: " + flasher.get_last_error()) << std::endl;
+        return false;
+    }
     
-    //  Wait for device to stabilize in bootloader mode
-    std::cout << "Waiting for device to stabilize in bootloader mode..." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    std::cout << DpcColors::ok("Firmware uploaded successfully (" + std::to_string(image.size()) + " bytes in " +
+                               std::to_string(flasher.get_timings().total().count()) + " ms)") << std::endl;
+    const DpcFlasher::Report& report = flasher.get_report();
+    if (report.delta) {
+        std::cout << "Delta flash: " << report.rows_skipped << " of " << report.rows_total << " rows unchanged, "
+                  << report.bytes_saved << " bytes not rewritten" << std::endl;
+    }
+    
+    // Write and verify times side by side, so the cost of verification is visible
+    long long writeMs = 0;
+    long long verifyMs = -1;
+    for (const auto& entry : flasher.get_timings().entries()) {
+        if (entry.label == "write") writeMs = entry.elapsed.count();
+        if (entry.label == "verify") verifyMs = entry.elapsed.count();
+    }
+    std::cout << "Write: " << writeMs << " ms, verify: ";
+    if (verifyMs < 0) {
+        std::cout << "skipped" << std::endl;
+    } else if (plan.flashOptions.verify == DpcFlasher::Verify::ReadBack) {
+        std::cout << verifyMs << " ms (full read-back)" << std::endl;
+    } else {
+        std::cout << verifyMs << " ms (checksum, " << report.regions_read_back << " regions read back)" << std::endl;
+    }
+    return true;
+}
+
+bool DpcFirmware::flashWithBossac(const UploadPlan& plan, DeviceUpload& upload) {
+    // Wait until the bootloader answers rather than a fixed settling time
+    std::cout << "Waiting for bootloader to respond..." << std::endl;
+    upload.flashTimings.clear();
+    auto start = DpcTiming::Clock::now();
+    bool ready = DpcFlasher::wait_for_bootloader(upload.bootloaderPort, start + BOOTLOADER_READY_TIMEOUT);
+    upload.flashTimings.record("bootloader ready", start, ready ? DpcTiming::Status::Completed : DpcTiming::Status::Timeout);
+    if (!ready) {
+        std::cerr << DpcColors::error("Bootloader on " + upload.bootloaderPort + " does not respond") << std::endl;
+        return false;
+    }
     
     // Step 5.1: Build and execute bossac command
-    std::cout << "Using bootloader port for firmware upload: " << port << std::endl;
-    std::string bossacCommand = buildBossacCommand(finalBossacPath, port, finalFirmwarePath);
+    std::string bossacCommand = buildBossacCommand(plan.bossacPath, upload.bootloaderPort, plan.firmwarePath);
     
     if (m_verbose) {
         std::cout << std::endl;
@@ -156,43 +335,50 @@ bool DpcFirmware::uploadFirmware(DpcDevice* device, const std::string& firmwareP
     
     // Step 5.2: Upload firmware
     std::cout << "Uploading firmware to device..." << std::endl;
-    if (!executeBossacCommand(bossacCommand)) {
+    bool flashed = executeBossacCommand(bossacCommand, upload.flashTimings);
+    if (m_verbose) {
+        std::cout << "Flash timings:" << std::endl;
+        upload.flashTimings.print(std::cout);
+    }
+    if (!flashed) {
         std::cerr << DpcColors::error("Firmware upload failed") << std::endl;
         return false;
     }
     
     std::cout << DpcColors::ok("Firmware uploaded successfully") << std::endl;
-    
-    // Step 6: Waiting for device reboot and restore settings
-    std::cout << std::endl << DpcColors::step("Step 7/7: Waiting for device reboot and restoring settings...") << std::endl;
-    
+    return true;
+}
+
+bool DpcFirmware::restoreSettings(DpcDevice& device, DeviceUpload& upload) {
     std::cout << "Waiting for device to reboot..." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(4));
     
-    bool settings_restored = false;
+    upload.settingsRestored = false;
+    bool reconnected = false;
     
     try {
-        // Step 6.1: Reconnect to the device (port may have changed after firmware upload)
-        if (!device->find_and_connect()) {
+        // Step 6.1: Reconnect once the application has enumerated and finished booting
+        // (port may have changed after firmware upload)
+        if (!device.reconnect_application(DpcSerial::Clock::now() + REBOOT_TIMEOUT)) {
             std::cerr << DpcColors::warning("Could not reconnect to device after firmware upload") << std::endl;
             std::cerr << "         Settings were backed up but not restored" << std::endl;
-        } else if (device->is_in_bootloader_mode()) {
+        } else if (device.is_in_bootloader_mode()) {
             std::cerr << DpcColors::warning("Device still in bootloader mode after firmware upload") << std::endl;
             std::cerr << "         Settings were backed up but not restored" << std::endl;
         } else {
+            reconnected = true;
             std::cout << DpcColors::ok("Device reconnected successfully") << std::endl;
             
             // Step 6.2: Restore settings from backup file (only if we backed up settings)
-            if (!skip_settings) {
-                if (settingsManager.restore_settings_from_backup(*device, backupFilename)) {
-                    settings_restored = true;
+            if (!upload.skipSettings) {
+                DpcSettings settingsManager;
+                if (settingsManager.restore_settings_from_backup(device, upload.backupFilename)) {
+                    upload.settingsRestored = true;
                 } else {
                     std::cerr << DpcColors::warning("Failed to restore settings to device") << std::endl;
                     std::cerr << "         Settings backup file can be used for manual restoration" << std::endl;
                 }
             } else {
                 std::cout << DpcColors::warning("No settings backup available - skipping restore") << std::endl;
-                settings_restored = false;
             }
         }
         
@@ -201,17 +387,7 @@ bool DpcFirmware::uploadFirmware(DpcDevice* device, const std::string& firmwareP
         std::cerr << "         Settings backup file can be used for manual restoration" << std::endl;
     }
     
-    std::cout << std::endl;
-    if (settings_restored) {
-        std::cout << DpcColors::ok("Firmware upload completed successfully and device settings restored!") << std::endl;
-    } else {
-        std::cout << DpcColors::warning("Firmware upload completed successfully, device settings NOT restored.") << std::endl;
-        if (!skip_settings) {
-            std::cout << "Use the settings backup file for restoration with the restore-settings command if desired." << std::endl;
-        }
-    }
-    
-    return true;
+    return reconnected;
 }
 
 bool DpcFirmware::checkBossacExecutable(const std::string& bossacPath) {
@@ -344,32 +520,54 @@ std::string DpcFirmware::buildBossacCommand(const std::string& bossacPath, const
     return cmd.str();
 }
 
-bool DpcFirmware::executeBossacCommand(const std::string& command) {
+bool DpcFirmware::executeBossacCommand(const std::string& command, DpcTiming& timings) {
     if (m_verbose) {
         std::cout << "Executing: " << command << std::endl;
-        std::cout << "Command length: " << command.length() << " characters" << std::endl;
         std::cout << "Current working directory: " << getExecutableDirectory() << std::endl;
     }
     
-    // On Windows, use cmd /c to properly handle quoted commands
-    std::string finalCommand;
-#ifdef _WIN32
-    finalCommand = "cmd /c \"" + command + "\"";
-#else
-    finalCommand = command;
-#endif
-    
-    if (m_verbose) {
-        std::cout << "Final command: " << finalCommand << std::endl;
-    }
-    
-    int result = system(finalCommand.c_str());
-    
-    if (m_verbose) {
-        std::cout << "Command result: " << result << std::endl;
+    // Parse bossac's output as it arrives: its progress drives our progress bar, other
+    // lines are shown in verbose mode (and the last ones on failure)
+    DpcBossac bossac(m_verbose);
+    DpcProgress progress;
+    bool showProgress = m_showProgress;
+    bool verbose = m_verbose;
+    bool succeeded = bossac.run(command, [&](const DpcBossac::Event& event) {
+        switch (event.type) {
+        case DpcBossac::Event::Type::PhaseStart:
+        case DpcBossac::Event::Type::Progress:
+            if (showProgress) {
+                progress.update(event.phase, event.done, event.total);
+            }
+            break;
+        case DpcBossac::Event::Type::PhaseDone:
+            if (showProgress) {
+                progress.update(event.phase, event.total, event.total);
+            }
+            break;
+        case DpcBossac::Event::Type::Error:
+            progress.finish();
+            std::cerr << DpcColors::error(event.text) << std::endl;
+            break;
+        case DpcBossac::Event::Type::Reset:
+        case DpcBossac::Event::Type::Info:
+            if (verbose) {
+                progress.finish();
+                std::cout << "  " << event.text << std::endl;
+            }
+            break;
+        }
+    });
+    progress.finish();
+    timings.append(bossac.getTimings());
+    
+    if (!succeeded) {
+        std::cerr << "bossac exited with code " << bossac.getExitCode() << ", last output:" << std::endl;
+        for (const auto& line : bossac.getOutputTail()) {
+            std::cerr << "  " << line << std::endl;
+        }
     }
-    
-    return result == 0;
+    return succeeded;
 }
 
 bool DpcFirmware::fileExists(const std::string& path) {
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <chrono>
+#include "DpcFlasher.h"
+#include "DpcTiming.h"
 
 class DpcSerial;
 class DpcDevice;
@@ -13,6 +16,49 @@ public:
     bool uploadFirmware(DpcDevice* device, const std::string& firmwarePath = "", const std::string& bossacPath = "", 
                        const std::string& version = "latest", const std::string& binaryUrl = "");
     
+    // Flashing backend: built-in SAM-BA flasher (DpcFlasher) or the bossac tool
+    enum class Flasher { Native, Bossac };
+    
+    // Backend and native flasher options used by uploadFirmware()
+    void setFlasher(Flasher flasher, const DpcFlasher::Options& flashOptions = DpcFlasher::Options());
+    
+    // Progress bar while flashing (off for the fleet upload, whose output is line-based)
+    void setShowProgress(bool showProgress);
+    
+    // Resolve firmware from the local cache only (see DpcDownload::setOffline)
+    void setOffline(bool offline);
+    
+    // Firmware source for downloads (see DpcDownload::setSource); empty for GitHub
+    void setSource(const std::string& source);
+    
+    // Firmware and tool for an upload, resolved once and shared by all devices
+    struct UploadPlan {
+        std::string firmwarePath;
+        Flasher flasher = Flasher::Native;
+        std::string bossacPath;                         // Bossac backend only
+        DpcFlasher::Options flashOptions;               // Native backend only
+    };
+    
+    // Per-device state carried from phase to phase
+    struct DeviceUpload {
+        std::string backupFilename;     // Set before backupSettings() to choose the file
+        bool skipSettings = false;      // Device was already in bootloader mode
+        bool settingsRestored = false;
+        std::string bootloaderPort;
+        DpcTiming flashTimings;         // Native backend: connect, compare, erase, write, verify, reset
+        DpcFlasher::Report flashReport; // Native backend: rows skipped by delta flashing
+    };
+    
+    // Upload phases, used in order by uploadFirmware() and by the fleet upload (DpcFleet).
+    // prepareUpload covers download and checks; the others run per device.
+    // prepareUpload keeps plan.flasher and plan.flashOptions as set by the caller.
+    bool prepareUpload(UploadPlan& plan, const std::string& firmwarePath, const std::string& bossacPath,
+                       const std::string& version, const std::string& binaryUrl);
+    bool backupSettings(DpcDevice& device, DeviceUpload& upload, bool interactive);
+    bool enterBootloader(DpcDevice& device, DeviceUpload& upload);
+    bool flashFirmware(const UploadPlan& plan, DeviceUpload& upload);
+    bool restoreSettings(DpcDevice& device, DeviceUpload& upload);  // false: not reconnected after flashing
+    
     // Check if bossac executable exists and is accessible
     bool checkBossacExecutable(const std::string& bossacPath = "");
     
@@ -25,13 +71,30 @@ public:
     
 private:
     bool m_verbose;
+    bool m_showProgress;
+    bool m_offline;
+    std::string m_source;
+    Flasher m_flasher;
+    DpcFlasher::Options m_flashOptions;
     
     // Helper functions
     std::string buildBossacCommand(const std::string& bossacPath, const std::string& port, const std::string& firmwarePath);
-    bool executeBossacCommand(const std::string& command);
+    bool executeBossacCommand(const std::string& command, DpcTiming& timings);
+    bool flashWithBossac(const UploadPlan& plan, DeviceUpload& upload);
+    bool flashNative(const UploadPlan& plan, DeviceUpload& upload);
+    
+    // Parts of prepareUpload, run as separate tasks by uploadFirmware()
+    bool resolveFirmware(UploadPlan& plan, const std::string& firmwarePath, const std::string& version,
+                         const std::string& binaryUrl);
+    bool checkFlasher(UploadPlan& plan, const std::string& bossacPath);
+    bool checkFirmware(const UploadPlan& plan);
     static bool fileExists(const std::string& path);
     static std::string getExecutableDirectory();
     
+    // Readiness deadlines around flashing
+    static constexpr std::chrono::seconds BOOTLOADER_READY_TIMEOUT{5};
+    static constexpr std::chrono::seconds REBOOT_TIMEOUT{15};
+    
     // Platform-specific path constants
     static constexpr const char* DEFAULT_FIRMWARE_PATH = "firmware.bin";
     
@@ -0,0 +1,310 @@
+// diyPresso Client Firmware Flasher - Platform support: macOS 13+ and Windows 10/11 only
+#include "DpcFlasher.h"
+#include "DpcSamba.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <thread>
+
+DpcFlasher::DpcFlasher(bool verbose) : verbose_(verbose) {
+}
+
+bool DpcFlasher::flash(const std::string& port, const std::vector<uint8_t>& image, const Options& options,
+                       const ProgressCallback& progress) {
+    timings_.clear();
+    last_error_.clear();
+    bootloader_version_.clear();
+
+    if (options.block_size == 0 || options.block_size > MAX_BLOCK_SIZE || options.block_size % PAGE_SIZE != 0) {
+        last_error_ = "block size must be a multiple of " + std::to_string(PAGE_SIZE) +
+                      " bytes up to " + std::to_string(MAX_BLOCK_SIZE);
+        return false;
+    }
+    if (image.empty() || image.size() > FLASH_SIZE - APP_START) {
+        last_error_ = "firmware image size " + std::to_string(image.size()) + " bytes does not fit the application flash";
+        return false;
+    }
+
+    // Flash is erased in rows and written in pages; erased flash reads as 0xFF
+    std::vector<uint8_t> padded(image);
+    padded.resize((image.size() + ROW_SIZE - 1) / ROW_SIZE * ROW_SIZE, 0xFF);
+    size_t total = padded.size();
+    size_t rows = total / ROW_SIZE;
+    report_ = Report();
+    report_.rows_total = rows;
+    auto report = [&](const char* phase, size_t done, size_t of) {
+        if (progress) progress(phase, done, of);
+    };
+
+    DpcSerial serial;
+    serial.set_verbose(verbose_);
+    std::string phase = "connect";
+    auto phase_start = DpcTiming::Clock::now();
+
+    try {
+        if (!serial.open(port, 115200)) {
+            throw std::runtime_error("cannot open " + port + " (" + serial.get_last_error() + ")");
+        }
+        DpcSamba samba(serial);
+        samba.connect(DpcSerial::Clock::now() + CONNECT_TIMEOUT);
+        bootloader_version_ = samba.get_version();
+        if (verbose_) {
+            std::cout << "Bootloader: " << bootloader_version_ << std::endl;
+        }
+        if (!samba.can_erase() || !samba.can_write_buffer()) {
+            throw std::runtime_error("bootloader does not support the Arduino erase/write extensions (" +
+                                     bootloader_version_ + ")");
+        }
+        timings_.record(phase, phase_start, DpcTiming::Status::Completed);
+
+        // Compare with the flash already on the device
+        std::vector<bool> changed(rows, true);
+        if (options.delta && samba.can_checksum()) {
+            phase = "compare";
+            phase_start = DpcTiming::Clock::now();
+            changed = find_changed_rows(samba, padded, [&](size_t done) { report("compare", done, total); });
+            report_.delta = true;
+            timings_.record(phase, phase_start, DpcTiming::Status::Completed);
+        } else if (options.delta && verbose_) {
+            std::cout << "Bootloader has no checksum command, flashing the whole image" << std::endl;
+        }
+        report_.rows_skipped = static_cast<size_t>(std::count(changed.begin(), changed.end(), false));
+        size_t changed_bytes = (rows - report_.rows_skipped) * ROW_SIZE;
+        report_.bytes_saved = report_.rows_skipped * ROW_SIZE;
+
+        phase = "erase";
+        phase_start = DpcTiming::Clock::now();
+        if (report_.delta) {
+            // Changed rows up to the end of the image are erased with a single X, which also
+            // clears whatever a larger previous image left behind; other rows one by one
+            size_t tail_row = rows;
+            while (tail_row > 0 && changed[tail_row - 1]) {
+                --tail_row;
+            }
+            size_t erased = 0;
+            report("erase", 0, changed_bytes);
+            for (size_t row = 0; row < tail_row; ++row) {
+                if (changed[row]) {
+                    erase_row(samba, APP_START + static_cast<uint32_t>(row * ROW_SIZE));
+                    report("erase", ++erased * ROW_SIZE, changed_bytes);
+                }
+            }
+            uint32_t tail = APP_START + static_cast<uint32_t>(tail_row * ROW_SIZE);
+            if (tail_row < rows) {
+                samba.erase_from(tail);
+                report("erase", changed_bytes, changed_bytes);
+            } else if (tail < FLASH_SIZE) {
+                std::vector<uint8_t> blank(FLASH_SIZE - tail, 0xFF);
+                if (samba.checksum(tail, blank.size()) != DpcSamba::crc16(blank.data(), blank.size())) {
+                    samba.erase_from(tail);
+                }
+            }
+        } else {
+            // X erases from the address to the end of flash
+            report("erase", 0, total);
+            samba.erase_from(APP_START);
+            report("erase", total, total);
+        }
+        timings_.record(phase, phase_start, DpcTiming::Status::Completed);
+
+        // Write each run of changed rows
+        phase = "write";
+        phase_start = DpcTiming::Clock::now();
+        size_t written = 0;
+        report("write", 0, changed_bytes);
+        for (size_t row = 0; row < rows;) {
+            if (!changed[row]) {
+                ++row;
+                continue;
+            }
+            size_t first = row;
+            while (row < rows && changed[row]) {
+                ++row;
+            }
+            size_t size = (row - first) * ROW_SIZE;
+            write_range(samba, padded, first * ROW_SIZE, size, options.block_size,
+                        [&](size_t done) { report("write", written + done, changed_bytes); });
+            written += size;
+        }
+        report_.bytes_written = written;
+        timings_.record(phase, phase_start, DpcTiming::Status::Completed);
+
+        if (options.verify != Verify::None) {
+            phase = "verify";
+            phase_start = DpcTiming::Clock::now();
+            bool use_checksum = options.verify == Verify::Checksum && samba.can_checksum();
+            for (size_t offset = 0; offset < total; offset += VERIFY_REGION_SIZE) {
+                size_t size = std::min<size_t>(VERIFY_REGION_SIZE, total - offset);
+                uint32_t address = APP_START + static_cast<uint32_t>(offset);
+                if (!use_checksum || samba.checksum(address, size) != DpcSamba::crc16(padded.data() + offset, size)) {
+                    if (use_checksum) {
+                        report_.regions_read_back++;
+                    }
+                    verify_range(samba, padded, offset, size);
+                }
+                report("verify", offset + size, total);
+            }
+            if (use_checksum && report_.delta) {
+                verify_unchanged_rows(samba, padded, changed);
+            }
+            timings_.record(phase, phase_start, DpcTiming::Status::Completed);
+        }
+
+        if (options.reset) {
+            phase = "reset";
+            phase_start = DpcTiming::Clock::now();
+            samba.reset();
+            timings_.record(phase, phase_start, DpcTiming::Status::Completed);
+        }
+    } catch (const std::exception& e) {
+        timings_.record(phase, phase_start, DpcTiming::Status::Error);
+        last_error_ = phase + ": " + e.what();
+        serial.close();
+        return false;
+    }
+
+    serial.close();
+    return true;
+}
+
+bool DpcFlasher::wait_for_bootloader(const std::string& port, DpcSerial::Deadline deadline) {
+    while (true) {
+        DpcSerial serial;
+        if (serial.open(port, 115200)) {
+            try {
+                DpcSamba samba(serial);
+                samba.connect(deadline);
+                return true;
+            } catch (const std::exception&) {
+                // Handshake ran into the deadline
+            }
+        }
+        if (DpcSerial::Clock::now() >= deadline) {
+            return false;
+        }
+        // Port not accessible yet
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+bool DpcFlasher::load_image(const std::string& path, std::vector<uint8_t>& image) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+std::vector<bool> DpcFlasher::find_changed_rows(DpcSamba& samba, const std::vector<uint8_t>& image,
+                                                 const std::function<void(size_t)>& progress) {
+    // One checksum per block first: most blocks of a minor update are unchanged, and
+    // only blocks that differ need a checksum per row
+    std::vector<bool> changed(image.size() / ROW_SIZE, false);
+    for (size_t offset = 0; offset < image.size(); offset += COMPARE_BLOCK_SIZE) {
+        size_t size = std::min<size_t>(COMPARE_BLOCK_SIZE, image.size() - offset);
+        uint32_t address = APP_START + static_cast<uint32_t>(offset);
+        if (samba.checksum(address, size) != DpcSamba::crc16(image.data() + offset, size)) {
+            for (size_t row = offset; row < offset + size; row += ROW_SIZE) {
+                if (samba.checksum(APP_START + static_cast<uint32_t>(row), ROW_SIZE) !=
+                    DpcSamba::crc16(image.data() + row, ROW_SIZE)) {
+                    changed[row / ROW_SIZE] = true;
+                }
+            }
+        }
+        progress(offset + size);
+    }
+    return changed;
+}
+
+void DpcFlasher::erase_row(DpcSamba& samba, uint32_t address) {
+    samba.write_word(NVMCTRL_ADDR, address / 2);
+    samba.write_word(NVMCTRL_CTRLA, NVMCTRL_CMD_ERASE_ROW);
+
+    auto deadline = DpcSerial::Clock::now() + ROW_ERASE_TIMEOUT;
+    while (!(samba.read_word(NVMCTRL_INTFLAG) & NVMCTRL_INTFLAG_READY)) {
+        if (DpcSerial::Clock::now() >= deadline) {
+            char text[16];
+            std::snprintf(text, sizeof(text), "0x%08X", static_cast<unsigned>(address));
+            throw std::runtime_error(std::string("timeout erasing row at ") + text);
+        }
+    }
+}
+
+void DpcFlasher::write_range(DpcSamba& samba, const std::vector<uint8_t>& image, size_t offset, size_t size,
+                             size_t block_size, const std::function<void(size_t)>& progress) {
+    // Alternate between two RAM buffers so the next block is already on its way
+    // while the bootloader is still programming the previous one
+    const uint32_t buffers[2] = {RAM_BUFFER_A, RAM_BUFFER_B};
+    size_t block_index = 0;
+    for (size_t done = 0; done < size; done += block_size, ++block_index) {
+        size_t count = std::min(block_size, size - done);
+        uint32_t buffer = buffers[block_index % 2];
+        samba.write_memory(buffer, image.data() + offset + done, count);
+        samba.finish_copy_to_flash();
+        progress(done);
+        samba.start_copy_to_flash(buffer, APP_START + static_cast<uint32_t>(offset + done), count);
+    }
+    samba.finish_copy_to_flash();
+    progress(size);
+}
+
+void DpcFlasher::verify_range(DpcSamba& samba, const std::vector<uint8_t>& image, size_t offset, size_t size) {
+    std::vector<uint8_t> readback(size);
+    samba.read_memory(APP_START + static_cast<uint32_t>(offset), readback.data(), size);
+    auto mismatch = std::mismatch(readback.begin(), readback.end(), image.begin() + offset);
+    if (mismatch.first != readback.end()) {
+        char address[16];
+        std::snprintf(address, sizeof(address), "0x%08X",
+                      static_cast<unsigned>(APP_START + offset + (mismatch.first - readback.begin())));
+        throw std::runtime_error(std::string("verify failed at ") + address);
+    }
+}
+
+void DpcFlasher::verify_unchanged_rows(DpcSamba& samba, const std::vector<uint8_t>& image,
+                                       const std::vector<bool>& changed) {
+    // The compare skipped these rows on the CRC16 of row- and block-aligned regions, which
+    // the region checksums above repeat: a collision there would pass both. Check them
+    // again over windows starting half a row off, so each CRC covers different bytes.
+    for (size_t row = 0; row < changed.size();) {
+        if (changed[row]) {
+            ++row;
+            continue;
+        }
+        size_t offset = row * ROW_SIZE;
+        while (row < changed.size() && !changed[row]) {
+            ++row;
+        }
+        size_t end = row * ROW_SIZE;
+        size_t size = ROW_SIZE / 2;
+        while (offset < end) {
+            size = std::min(size, end - offset);
+            uint32_t address = APP_START + static_cast<uint32_t>(offset);
+            if (samba.checksum(address, size) != DpcSamba::crc16(image.data() + offset, size)) {
+                report_.regions_read_back++;
+                verify_range(samba, image, offset, size);
+            }
+            offset += size;
+            size = VERIFY_REGION_SIZE;
+        }
+    }
+}
+
+const DpcTiming& DpcFlasher::get_timings() const {
+    return timings_;
+}
+
+const DpcFlasher::Report& DpcFlasher::get_report() const {
+    return report_;
+}
+
+std::string DpcFlasher::get_last_error() const {
+    return last_error_;
+}
+
+std::string DpcFlasher::get_bootloader_version() const {
+    return bootloader_version_;
+}
@@ -0,0 +1,103 @@
+// diyPresso Client Firmware Flasher - Platform support: macOS 13+ and Windows 10/11 only
+#pragma once
+#include "DpcSerial.h"
+#include "DpcTiming.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+// Writes an application image to the MKR WiFi 1010 (SAMD21G18) through its SAM-BA
+// bootloader: erase, write, verify, reset. Replaces the bossac subprocess; each phase
+// is recorded in get_timings() and reported through the progress callback.
+//
+// With Options::delta the flash already on the device is compared row by row (on-chip
+// CRC16, Z command) and only rows that differ are erased and rewritten. Verification
+// uses the same checksums and reads back only regions whose checksum does not match;
+// rows skipped as unchanged are checked again over differently aligned windows, so a
+// CRC collision in the compare cannot also pass verification.
+class DpcSamba;
+
+class DpcFlasher {
+public:
+    enum class Verify {
+        None,
+        Checksum,       // On-chip CRC16 per region, read back only regions that mismatch
+        ReadBack        // Read the whole image back over USB (paranoid)
+    };
+
+    struct Options {
+        size_t block_size = MAX_BLOCK_SIZE;     // Bytes per RAM transfer, multiple of PAGE_SIZE
+        Verify verify = Verify::Checksum;
+        bool reset = true;                      // Start the new application when done
+        bool delta = true;                      // Only erase and write rows that changed
+    };
+
+    // Outcome of the last flash(); rows are ROW_SIZE bytes of the (padded) image
+    struct Report {
+        size_t rows_total = 0;
+        size_t rows_skipped = 0;                // Already identical on the device
+        size_t bytes_written = 0;
+        size_t bytes_saved = 0;                 // Not erased and rewritten thanks to delta flashing
+        bool delta = false;                     // false: whole application area erased and written
+        size_t regions_read_back = 0;           // Verify: regions read back after a checksum mismatch
+    };
+
+    // Called with the current phase ("compare", "erase", "write", "verify") and its progress in bytes
+    using ProgressCallback = std::function<void(const std::string& phase, size_t done, size_t total)>;
+
+    explicit DpcFlasher(bool verbose = false);
+
+    // Flash a firmware image to the bootloader on 'port'. Returns false with get_last_error() set.
+    bool flash(const std::string& port, const std::vector<uint8_t>& image, const Options& options,
+               const ProgressCallback& progress = nullptr);
+
+    static bool load_image(const std::string& path, std::vector<uint8_t>& image);
+
+    // Wait until the bootloader on 'port' answers the SAM-BA handshake, for external
+    // flashers (bossac) that do not retry it themselves
+    static bool wait_for_bootloader(const std::string& port, DpcSerial::Deadline deadline);
+
+    const DpcTiming& get_timings() const;
+    const Report& get_report() const;
+    std::string get_last_error() const;
+    std::string get_bootloader_version() const;
+
+    // SAMD21G18 memory map as used by the Arduino bootloader
+    static constexpr uint32_t APP_START = 0x2000;          // First 8 KB hold the bootloader
+    static constexpr uint32_t FLASH_SIZE = 0x40000;        // 256 KB
+    static constexpr uint32_t PAGE_SIZE = 64;              // Flash write granularity
+    static constexpr uint32_t ROW_SIZE = 256;              // Flash erase granularity (4 pages)
+    static constexpr uint32_t RAM_BUFFER_A = 0x20005000;   // Transfer buffers, clear of the bootloader's
+    static constexpr uint32_t RAM_BUFFER_B = 0x20006000;   // data and stack
+    static constexpr size_t MAX_BLOCK_SIZE = 4096;         // Size of each RAM buffer
+
+private:
+    bool verbose_;
+    DpcTiming timings_;
+    Report report_;
+    std::string last_error_;
+    std::string bootloader_version_;
+
+    // Budget for the bootloader to answer after its port appeared
+    static constexpr std::chrono::seconds CONNECT_TIMEOUT{5};
+
+    // Rows of the image that differ from the device's flash
+    std::vector<bool> find_changed_rows(DpcSamba& samba, const std::vector<uint8_t>& image,
+                                        const std::function<void(size_t)>& progress);
+    void erase_row(DpcSamba& samba, uint32_t address);
+    void write_range(DpcSamba& samba, const std::vector<uint8_t>& image, size_t offset, size_t size,
+                     size_t block_size, const std::function<void(size_t)>& progress);
+    void verify_range(DpcSamba& samba, const std::vector<uint8_t>& image, size_t offset, size_t size);
+    void verify_unchanged_rows(DpcSamba& samba, const std::vector<uint8_t>& image, const std::vector<bool>& changed);
+
+    // NVM controller registers, for erasing single rows (X only erases to the end of flash)
+    static constexpr uint32_t NVMCTRL_CTRLA = 0x41004000;
+    static constexpr uint32_t NVMCTRL_INTFLAG = 0x41004014;
+    static constexpr uint32_t NVMCTRL_ADDR = 0x4100401C;     // Address in 16-bit words
+    static constexpr uint32_t NVMCTRL_CMD_ERASE_ROW = 0xA502;  // CMDEX key 0xA5, command ER
+    static constexpr uint32_t NVMCTRL_INTFLAG_READY = 0x01;
+    static constexpr std::chrono::milliseconds ROW_ERASE_TIMEOUT{100};
+    static constexpr size_t COMPARE_BLOCK_SIZE = 4096;       // Checksummed as a whole before row by row
+    static constexpr size_t VERIFY_REGION_SIZE = 4096;       // Checksummed, and read back on mismatch
+};
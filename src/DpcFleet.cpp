@@ -0,0 +1,240 @@
+#include "DpcFleet.h"
+#include "DpcDevice.h"
+#include "DpcColors.h"
+#include "DpcOutput.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <ctime>
+
+namespace {
+
+// Collects each device's output into whole lines and writes them prefixed with the
+// device label (the output source is the controller index), so concurrent uploads stay readable
+class PrefixedOutput : public DpcOutput::Router {
+public:
+    explicit PrefixedOutput(const std::vector<std::string>& labels) : m_labels(labels) {
+    }
+
+    void write(DpcOutput& output, DpcOutput::Stream stream, DpcOutput::SourceId source,
+               const char* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string& pending = m_pending[{stream, source}];
+        for (size_t i = 0; i < size; ++i) {
+            pending += data[i];
+            if (data[i] == '\n') {
+                writeLine(output, stream, source, pending);
+                pending.clear();
+            }
+        }
+    }
+
+    // Nothing reaches the console before its line is complete
+    bool isDirect(DpcOutput::SourceId /* source */) override {
+        return false;
+    }
+
+    void finish(DpcOutput& output) override {
+        // Emit unterminated output before the original buffers are restored
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& [key, pending] : m_pending) {
+            if (!pending.empty()) {
+                writeLine(output, key.first, key.second, pending + "\n");
+            }
+        }
+        m_pending.clear();
+    }
+
+private:
+    void writeLine(DpcOutput& output, DpcOutput::Stream stream, DpcOutput::SourceId source, const std::string& line) {
+        std::string out = (source < m_labels.size()) ? "[" + m_labels[source] + "] " + line : line;
+        output.write(stream, out.data(), out.size());
+        output.flush(stream);
+    }
+
+    const std::vector<std::string>& m_labels;
+    std::mutex m_mutex;
+    std::map<std::pair<DpcOutput::Stream, DpcOutput::SourceId>, std::string> m_pending;
+};
+
+std::string formatPhase(const DpcTiming& phases, const std::string& label) {
+    for (const auto& entry : phases.entries()) {
+        if (entry.label == label) {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(1) << entry.elapsed.count() / 1000.0 << "s";
+            if (entry.status != DpcTiming::Status::Completed) {
+                ss << "!";
+            }
+            return ss.str();
+        }
+    }
+    return "-";
+}
+
+const char* const PHASES[] = {"connect", "backup", "reset", "flash", "restore"};
+
+} // namespace
+
+DpcFleet::DpcFleet(bool verbose, size_t jobs) : m_verbose(verbose), m_jobs(std::max<size_t>(1, jobs)) {
+}
+
+bool DpcFleet::uploadFirmware(const std::vector<DpcSerial::ControllerInfo>& controllers,
+                              const DpcFirmware::UploadPlan& plan) {
+    m_results.assign(controllers.size(), Result());
+    if (controllers.empty()) {
+        return false;
+    }
+
+    size_t workers = std::min(m_jobs, controllers.size());
+    std::cout << std::endl << DpcColors::step("Uploading firmware to " + std::to_string(controllers.size()) +
+                                              " devices (" + std::to_string(workers) + " in parallel)...") << std::endl;
+
+    // One timestamp for all backup files of this run (std::localtime is not thread-safe)
+    std::time_t now = std::time(nullptr);
+    std::ostringstream stamp;
+    stamp << std::put_time(std::localtime(&now), "%Y%m%d_%H%M%S");
+
+    std::vector<std::string> labels;
+    for (const auto& controller : controllers) {
+        labels.push_back(controller.port);
+    }
+    PrefixedOutput prefixed(labels);
+    {
+        DpcOutput output(prefixed);
+
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> pool;
+        for (size_t i = 0; i < workers; ++i) {
+            pool.emplace_back([&]() {
+                size_t index;
+                while ((index = next.fetch_add(1)) < controllers.size()) {
+                    DpcOutput::Source source(index);
+                    uploadDevice(controllers[index], plan, stamp.str(), m_results[index]);
+                }
+            });
+        }
+        for (auto& worker : pool) {
+            worker.join();
+        }
+    }
+
+    return std::all_of(m_results.begin(), m_results.end(), [](const Result& r) { return r.success; });
+}
+
+void DpcFleet::uploadDevice(const DpcSerial::ControllerInfo& controller, const DpcFirmware::UploadPlan& plan,
+                            const std::string& backupStamp, Result& result) {
+    // Only one device at a time may be between its bootloader reset and finding its
+    // bootloader: where USB locations change on re-enumeration, DpcDevice recognises
+    // its bootloader as the one that newly appeared
+    static std::mutex resetMutex;
+
+    result.device = selectorFor(controller);
+    result.port = controller.port;
+
+    DpcDevice device;
+    device.set_verbose(m_verbose);
+    device.set_device_selector(result.device);
+
+    DpcFirmware firmware(m_verbose);
+    firmware.setShowProgress(false);
+    DpcFirmware::DeviceUpload upload;
+    std::string id = controller.serial_number.empty() ? controller.port.substr(controller.port.find_last_of("/\\") + 1)
+                                                      : controller.serial_number;
+    upload.backupFilename = "settings_" + backupStamp + "_" + id + ".json";
+
+    auto runPhase = [&](const std::string& phase, auto&& action) {
+        std::cout << DpcColors::step(phase + "...") << std::endl;
+        auto start = DpcTiming::Clock::now();
+        bool ok = false;
+        try {
+            ok = action();
+        } catch (const std::exception& e) {
+            std::cerr << DpcColors::error(phase + " failed: " + e.what()) << std::endl;
+        }
+        result.phases.record(phase, start, ok ? DpcTiming::Status::Completed : DpcTiming::Status::Error);
+        if (!ok) {
+            result.failedPhase = phase;
+        }
+        return ok;
+    };
+
+    bool ok = runPhase("connect", [&]() { return device.find_and_connect(); })
+           && runPhase("backup", [&]() { return firmware.backupSettings(device, upload, false); })
+           && runPhase("reset", [&]() {
+                  std::lock_guard<std::mutex> lock(resetMutex);
+                  return firmware.enterBootloader(device, upload);
+              })
+           && runPhase("flash", [&]() { return firmware.flashFirmware(plan, upload); });
+    if (ok) {
+        // A device that does not come back still has its new firmware; settings stay in the backup file
+        runPhase("restore", [&]() { return firmware.restoreSettings(device, upload); });
+        result.failedPhase.clear();
+        result.settingsRestored = upload.settingsRestored;
+    }
+    device.disconnect();
+
+    result.success = ok;
+    if (ok) {
+        std::cout << DpcColors::ok(upload.settingsRestored ? "Firmware uploaded, settings restored"
+                                                           : "Firmware uploaded, settings NOT restored") << std::endl;
+    } else {
+        std::cerr << DpcColors::error("Upload failed in phase: " + result.failedPhase) << std::endl;
+    }
+}
+
+const std::vector<DpcFleet::Result>& DpcFleet::getResults() const {
+    return m_results;
+}
+
+void DpcFleet::printSummary(std::ostream& out) const {
+    size_t succeeded = std::count_if(m_results.begin(), m_results.end(), [](const Result& r) { return r.success; });
+
+    out << std::endl << DpcColors::highlight("=== Fleet Upload Summary ===") << std::endl;
+    out << std::left << std::setw(16) << "PORT" << std::setw(10) << "RESULT";
+    for (const char* phase : PHASES) {
+        out << std::setw(10) << phase;
+    }
+    out << std::setw(10) << "total" << "NOTES" << std::endl;
+
+    for (const auto& result : m_results) {
+        std::ostringstream total;
+        total << std::fixed << std::setprecision(1) << result.phases.total().count() / 1000.0 << "s";
+
+        out << std::left << std::setw(16) << result.port << std::setw(10) << (result.success ? "ok" : "FAILED");
+        for (const char* phase : PHASES) {
+            out << std::setw(10) << formatPhase(result.phases, phase);
+        }
+        out << std::setw(10) << total.str();
+        if (!result.success) {
+            out << "failed in " << result.failedPhase;
+        } else if (!result.settingsRestored) {
+            out << "settings not restored";
+        }
+        out << std::endl;
+    }
+
+    bool anyIncomplete = std::any_of(m_results.begin(), m_results.end(), [](const Result& r) {
+        return std::any_of(r.phases.entries().begin(), r.phases.entries().end(),
+                           [](const DpcTiming::Entry& e) { return e.status != DpcTiming::Status::Completed; });
+    });
+    out << succeeded << "/" << m_results.size() << " devices updated successfully";
+    if (anyIncomplete) {
+        out << " (\"!\" marks a phase that did not complete)";
+    }
+    out << std::endl;
+}
+
+std::string DpcFleet::selectorFor(const DpcSerial::ControllerInfo& controller) {
+    if (!controller.serial_number.empty()) {
+        return controller.serial_number;
+    }
+    if (!controller.location.empty()) {
+        return controller.location;
+    }
+    return controller.port;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "DpcFirmware.h"
+#include "DpcSerial.h"
+#include "DpcTiming.h"
+
+// Firmware upload to many controllers at once. Each device runs the DpcFirmware phases
+// (connect, backup, reset, flash, restore) on a bounded pool of worker threads; output
+// lines are prefixed with the device they belong to.
+class DpcFleet {
+public:
+    // Outcome of one device's upload
+    struct Result {
+        std::string device;         // Selector used for the device (serial number, location or port)
+        std::string port;
+        bool success = false;
+        bool settingsRestored = false;
+        std::string failedPhase;    // Empty on success
+        DpcTiming phases;           // One entry per phase that ran
+    };
+
+    DpcFleet(bool verbose = false, size_t jobs = DEFAULT_JOBS);
+
+    // Upload the plan's firmware to all controllers; true if every device succeeded
+    bool uploadFirmware(const std::vector<DpcSerial::ControllerInfo>& controllers,
+                        const DpcFirmware::UploadPlan& plan);
+
+    const std::vector<Result>& getResults() const;
+
+    // Table of per-phase timings and failures, one row per device
+    void printSummary(std::ostream& out) const;
+
+    // Most stable identifier to find a controller again: serial number, then location, then port
+    static std::string selectorFor(const DpcSerial::ControllerInfo& controller);
+
+    static constexpr size_t DEFAULT_JOBS = 4;
+
+private:
+    bool m_verbose;
+    size_t m_jobs;
+    std::vector<Result> m_results;
+
+    void uploadDevice(const DpcSerial::ControllerInfo& controller, const DpcFirmware::UploadPlan& plan,
+                      const std::string& backupStamp, Result& result);
+};
@@ -0,0 +1,147 @@
+// diyPresso Client Hotplug Discovery - Platform support: macOS 13+ and Windows 10/11 only
+#include "DpcHotplug.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__)
+    #include <sys/inotify.h>
+    #include <poll.h>
+    #include <unistd.h>
+#elif defined(__APPLE__)
+    #include <sys/event.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+DpcHotplug::DpcHotplug() : event_fd_(-1), watch_fd_(-1), settle_until_(Clock::now()) {
+#if defined(__linux__)
+    // USB CDC ACM ports show up as /dev/ttyACM*; udev then adjusts ownership and mode
+    event_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (event_fd_ != -1 && inotify_add_watch(event_fd_, "/dev", IN_CREATE | IN_ATTRIB | IN_MOVED_TO) == -1) {
+        ::close(event_fd_);
+        event_fd_ = -1;
+    }
+#elif defined(__APPLE__)
+    // devfs reports no names, only that /dev changed
+    watch_fd_ = ::open("/dev", O_EVTONLY);
+    if (watch_fd_ != -1) {
+        event_fd_ = kqueue();
+    }
+    if (event_fd_ != -1) {
+        struct kevent change;
+        EV_SET(&change, watch_fd_, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE | NOTE_LINK, 0, nullptr);
+        if (kevent(event_fd_, &change, 1, nullptr, 0, nullptr) == -1) {
+            ::close(event_fd_);
+            event_fd_ = -1;
+        }
+    }
+#endif
+    schedule_rescan(Clock::now());
+}
+
+DpcHotplug::~DpcHotplug() {
+#if defined(__linux__) || defined(__APPLE__)
+    if (event_fd_ != -1) {
+        ::close(event_fd_);
+    }
+    if (watch_fd_ != -1) {
+        ::close(watch_fd_);
+    }
+#endif
+}
+
+bool DpcHotplug::is_event_driven() const {
+    return event_fd_ != -1;
+}
+
+bool DpcHotplug::wait_for_change(Deadline deadline) {
+    while (true) {
+        auto now = Clock::now();
+        if (now >= next_rescan_) {
+            schedule_rescan(now);
+            return true;
+        }
+        if (now >= deadline) {
+            return false;
+        }
+
+        if (wait_for_event(std::min(deadline, next_rescan_))) {
+            now = Clock::now();
+            settle_until_ = now + SETTLE_WINDOW;
+            schedule_rescan(now);
+            return true;
+        }
+    }
+}
+
+bool DpcHotplug::wait_for_controller(const ControllerFilter& accept, Deadline deadline, DpcSerial::ControllerInfo& found) {
+    while (true) {
+        for (const auto& controller : DpcSerial::list_controllers()) {
+            if (accept(controller)) {
+                found = controller;
+                return true;
+            }
+        }
+        if (!wait_for_change(deadline)) {
+            return false;
+        }
+    }
+}
+
+void DpcHotplug::schedule_rescan(Clock::time_point now) {
+    if (!is_event_driven()) {
+        next_rescan_ = now + POLL_INTERVAL;
+    } else if (now < settle_until_) {
+        next_rescan_ = now + SETTLE_INTERVAL;
+    } else {
+        next_rescan_ = now + EVENT_FALLBACK_INTERVAL;
+    }
+}
+
+bool DpcHotplug::wait_for_event(Deadline until) {
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(until - Clock::now());
+    if (remaining.count() <= 0) {
+        return false;
+    }
+
+#if defined(__linux__)
+    if (event_fd_ != -1) {
+        struct pollfd pfd;
+        pfd.fd = event_fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, static_cast<int>(remaining.count())) <= 0) {
+            return false;   // Timeout or EINTR; the caller recomputes its wait
+        }
+
+        // Drain all queued events; only serial device nodes are relevant
+        bool relevant = false;
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t count;
+        while ((count = ::read(event_fd_, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + count; ) {
+                auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+                if (event->len > 0 && std::strncmp(event->name, "ttyACM", 6) == 0) {
+                    relevant = true;
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return relevant;
+    }
+#elif defined(__APPLE__)
+    if (event_fd_ != -1) {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        struct timespec timeout;
+        timeout.tv_sec = static_cast<time_t>(seconds.count());
+        timeout.tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count());
+        struct kevent event;
+        return kevent(event_fd_, nullptr, 0, &event, 1, &timeout) > 0;
+    }
+#endif
+
+    // No event source: sleep until the next timed rescan
+    std::this_thread::sleep_until(until);
+    return false;
+}
@@ -0,0 +1,56 @@
+// diyPresso Client Hotplug Discovery - Platform support: macOS 13+ and Windows 10/11 only
+#pragma once
+#include <string>
+#include <chrono>
+#include <functional>
+#include "DpcSerial.h"
+
+// Wakes device discovery when a serial device node appears instead of re-enumerating
+// USB on a fixed interval. Linux watches /dev with inotify, macOS with kqueue; other
+// platforms (and failed watch setup) fall back to a timed rescan.
+//
+// Create the watcher before triggering the change being waited for (e.g. the
+// bootloader reset), so a node that appears in between is not missed.
+class DpcHotplug {
+public:
+    using Clock = DpcSerial::Clock;
+    using Deadline = DpcSerial::Deadline;
+
+    DpcHotplug();
+    ~DpcHotplug();
+
+    // Delete copy constructor and assignment operator
+    DpcHotplug(const DpcHotplug&) = delete;
+    DpcHotplug& operator=(const DpcHotplug&) = delete;
+
+    // Whether device node events are available (false: timed rescans only)
+    bool is_event_driven() const;
+
+    // Block until the caller should rescan for devices: a serial device node was
+    // created or changed, or the fallback rescan interval elapsed.
+    // Returns false when the deadline passed first.
+    bool wait_for_change(Deadline deadline);
+
+    // Rescan until a controller accepted by the filter is found (true) or the deadline passes
+    using ControllerFilter = std::function<bool(const DpcSerial::ControllerInfo&)>;
+    bool wait_for_controller(const ControllerFilter& accept, Deadline deadline, DpcSerial::ControllerInfo& found);
+
+    // Rescan interval without device node events
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{500};
+    // Safety-net rescan interval while events are available
+    static constexpr std::chrono::milliseconds EVENT_FALLBACK_INTERVAL{2000};
+    // After an event the node may still be waiting for permissions or USB descriptors,
+    // so rescan quickly for a short while
+    static constexpr std::chrono::milliseconds SETTLE_INTERVAL{25};
+    static constexpr std::chrono::milliseconds SETTLE_WINDOW{1000};
+
+private:
+    // Wait for a relevant device node event until the given time (false: none)
+    bool wait_for_event(Deadline until);
+    void schedule_rescan(Clock::time_point now);
+
+    int event_fd_;      // inotify descriptor (Linux) or kqueue (macOS), -1 when unavailable
+    int watch_fd_;      // Watched /dev directory (macOS), -1 otherwise
+    Deadline next_rescan_;
+    Deadline settle_until_;
+};
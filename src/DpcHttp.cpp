@@ -0,0 +1,28 @@
+#include "DpcHttp.h"
+#include <stdexcept>
+
+DpcHttp::DpcHttp() : m_streaming(false) {
+    m_session.SetUserAgent(cpr::UserAgent{USER_AGENT});
+    m_session.SetConnectTimeout(cpr::ConnectTimeout{CONNECT_TIMEOUT_MS});
+}
+
+cpr::Response DpcHttp::get(const std::string& url, const cpr::Header& headers) {
+    // Callbacks stay installed on a session; one that streamed cannot go back to
+    // collecting the body in the response
+    if (m_streaming) {
+        throw std::logic_error("DpcHttp: get() on a client used for downloads");
+    }
+    m_session.SetUrl(cpr::Url{url});
+    m_session.SetHeader(headers);
+    return m_session.Get();
+}
+
+cpr::Response DpcHttp::download(const std::string& url, const cpr::Header& headers, const cpr::HeaderCallback& onHeader,
+                                const cpr::WriteCallback& onData, const cpr::ProgressCallback& onProgress) {
+    m_streaming = true;
+    m_session.SetUrl(cpr::Url{url});
+    m_session.SetHeader(headers);
+    m_session.SetHeaderCallback(onHeader);
+    m_session.SetProgressCallback(onProgress);
+    return m_session.Download(onData);
+}
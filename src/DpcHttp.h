@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <cpr/cpr.h>
+
+// HTTP client on one cpr::Session: consecutive requests to the same host reuse the
+// connection (keep-alive), saving a TCP and TLS handshake each. A session is not
+// thread-safe; concurrent requests use one client per thread.
+class DpcHttp {
+public:
+    DpcHttp();
+
+    cpr::Response get(const std::string& url, const cpr::Header& headers = cpr::Header());
+
+    // Streamed GET: the body goes to onData instead of the response text
+    cpr::Response download(const std::string& url, const cpr::Header& headers, const cpr::HeaderCallback& onHeader,
+                           const cpr::WriteCallback& onData, const cpr::ProgressCallback& onProgress);
+
+private:
+    cpr::Session m_session;
+    bool m_streaming;
+
+    static constexpr const char* USER_AGENT = "diyPresso-Client";     // Required by the GitHub API
+    static constexpr int32_t CONNECT_TIMEOUT_MS = 10000;
+};
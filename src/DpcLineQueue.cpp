@@ -0,0 +1,55 @@
+// diyPresso Client Line Queue - Platform support: macOS 13+ and Windows 10/11 only
+#include "DpcLineQueue.h"
+
+namespace {
+size_t round_up_to_power_of_two(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+}
+
+DpcLineQueue::DpcLineQueue(size_t capacity)
+    : slots_(round_up_to_power_of_two(capacity < 2 ? 2 : capacity)),
+      mask_(slots_.size() - 1),
+      head_(0),
+      tail_(0) {
+}
+
+bool DpcLineQueue::try_push(const char* data, size_t size) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= slots_.size()) {
+        return false;
+    }
+
+    slots_[tail & mask_].assign(data, size);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+std::string* DpcLineQueue::front() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &slots_[head & mask_];
+}
+
+void DpcLineQueue::pop() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+}
+
+bool DpcLineQueue::empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
+size_t DpcLineQueue::size() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
+
+size_t DpcLineQueue::capacity() const {
+    return slots_.size();
+}
@@ -0,0 +1,37 @@
+// diyPresso Client Line Queue - Platform support: macOS 13+ and Windows 10/11 only
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer/single-consumer queue of text lines.
+// The producer (serial reader thread) and the consumer (caller of readline) never lock;
+// slots keep their string capacity so steady-state pushes do not allocate.
+class DpcLineQueue {
+public:
+    explicit DpcLineQueue(size_t capacity);
+
+    // Delete copy constructor and assignment operator
+    DpcLineQueue(const DpcLineQueue&) = delete;
+    DpcLineQueue& operator=(const DpcLineQueue&) = delete;
+
+    // Producer side: copy a line into the next free slot, false if the queue is full
+    bool try_push(const char* data, size_t size);
+
+    // Consumer side: oldest line or nullptr if empty; pop() releases it
+    std::string* front();
+    void pop();
+
+    bool empty() const;
+    size_t size() const;
+    size_t capacity() const;
+
+private:
+    std::vector<std::string> slots_;
+    const size_t mask_;     // slots_.size() - 1 (size is a power of two)
+
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> head_;  // Next slot to consume
+    alignas(64) std::atomic<size_t> tail_;  // Next slot to fill
+};
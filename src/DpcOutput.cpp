@@ -0,0 +1,121 @@
+#include "DpcOutput.h"
+#include <iostream>
+#include <streambuf>
+#include <stdexcept>
+
+namespace {
+
+// The installed instance, guarded by g_activeMutex
+std::mutex g_activeMutex;
+DpcOutput* g_active = nullptr;
+
+thread_local DpcOutput::SourceId t_source = DpcOutput::NO_SOURCE;
+
+} // namespace
+
+// Replaces a standard stream's buffer and hands every write to the router
+class DpcOutput::Buffer : public std::streambuf {
+public:
+    Buffer(DpcOutput& output, Stream stream, std::ostream& ostream)
+        : m_output(output), m_stream(stream), m_ostream(ostream), m_target(ostream.rdbuf()), m_lastChar('\n') {
+        m_ostream.rdbuf(this);
+    }
+
+    void restore() {
+        m_ostream.rdbuf(m_target);
+    }
+
+    // Called with the output's write mutex held
+    void writeTarget(const char* data, size_t size, bool freshLine) {
+        if (size == 0) {
+            return;
+        }
+        if (freshLine && m_lastChar != '\n') {
+            m_target->sputc('\n');
+        }
+        m_target->sputn(data, static_cast<std::streamsize>(size));
+        m_lastChar = data[size - 1];
+    }
+
+    void syncTarget() {
+        m_target->pubsync();
+    }
+
+protected:
+    int overflow(int ch) override {
+        if (ch != traits_type::eof()) {
+            char c = static_cast<char>(ch);
+            xsputn(&c, 1);
+        }
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        m_output.m_router.write(m_output, m_stream, t_source, data, static_cast<size_t>(count));
+        return count;
+    }
+
+    int sync() override {
+        m_output.flush(m_stream);
+        return 0;
+    }
+
+private:
+    DpcOutput& m_output;
+    Stream m_stream;
+    std::ostream& m_ostream;
+    std::streambuf* m_target;
+    char m_lastChar;
+};
+
+DpcOutput::DpcOutput(Router& router) : m_router(router) {
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    if (g_active) {
+        throw std::logic_error("Console output is already being routed");
+    }
+    // Flush what was written before, so it cannot end up behind routed output
+    std::cout.flush();
+    std::cerr.flush();
+    m_out = std::make_unique<Buffer>(*this, Stream::Out, std::cout);
+    m_err = std::make_unique<Buffer>(*this, Stream::Err, std::cerr);
+    g_active = this;
+}
+
+DpcOutput::~DpcOutput() {
+    m_router.finish(*this);
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    m_out->restore();
+    m_err->restore();
+    g_active = nullptr;
+}
+
+void DpcOutput::write(Stream stream, const char* data, size_t size, bool freshLine) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    buffer(stream).writeTarget(data, size, freshLine);
+}
+
+void DpcOutput::flush(Stream stream) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    buffer(stream).syncTarget();
+}
+
+bool DpcOutput::isDirect() {
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    return !g_active || g_active->m_router.isDirect(t_source);
+}
+
+DpcOutput::Buffer& DpcOutput::buffer(Stream stream) {
+    return stream == Stream::Out ? *m_out : *m_err;
+}
+
+DpcOutput::Source::Source(SourceId id) : m_previous(t_source) {
+    t_source = id;
+}
+
+DpcOutput::Source::~Source() {
+    t_source = m_previous;
+}
+
+DpcOutput::SourceId DpcOutput::currentSource() {
+    return t_source;
+}
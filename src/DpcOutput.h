@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+// Routes std::cout and std::cerr while several threads write to the console, e.g. to hold
+// back or label the output of concurrent workflow steps. Each thread's output is tagged
+// with its source (see Source), and the installed Router decides where it goes.
+//
+// Only one DpcOutput can be installed at a time, and its destructor restores the original
+// stream buffers, so routing cannot nest or outlive the work it was installed for.
+class DpcOutput {
+public:
+    using SourceId = size_t;
+    static constexpr SourceId NO_SOURCE = static_cast<SourceId>(-1);   // Thread outside the routed work
+
+    enum class Stream { Out, Err };
+
+    // Decides where each write goes. Writes arrive from any thread, so a router does its
+    // own locking; DpcOutput::write() may be called with that lock held.
+    class Router {
+    public:
+        virtual ~Router() = default;
+        virtual void write(DpcOutput& output, Stream stream, SourceId source, const char* data, size_t size) = 0;
+        // Whether the source's writes reach the console right away (so it may redraw a line)
+        virtual bool isDirect(SourceId source) = 0;
+        // Called before the original buffers are restored, to write what is still pending
+        virtual void finish(DpcOutput& /* output */) {}
+    };
+
+    // Install 'router' for std::cout and std::cerr; throws std::logic_error when output is
+    // already being routed
+    explicit DpcOutput(Router& router);
+    ~DpcOutput();
+    DpcOutput(const DpcOutput&) = delete;
+    DpcOutput& operator=(const DpcOutput&) = delete;
+
+    // Write to the original console stream (for routers). With freshLine the text starts on
+    // a new line even when the previous write ended mid-line.
+    void write(Stream stream, const char* data, size_t size, bool freshLine = false);
+    void flush(Stream stream);
+
+    // Whether the calling thread's output reaches the console right away (always when not routed)
+    static bool isDirect();
+
+    // Tags the calling thread's output with a source for the lifetime of the object, e.g.
+    // a helper thread adopting the source of the thread that started it
+    class Source {
+    public:
+        explicit Source(SourceId id);
+        ~Source();
+        Source(const Source&) = delete;
+        Source& operator=(const Source&) = delete;
+
+    private:
+        SourceId m_previous;
+    };
+    static SourceId currentSource();
+
+private:
+    class Buffer;
+
+    Router& m_router;
+    std::unique_ptr<Buffer> m_out;
+    std::unique_ptr<Buffer> m_err;
+    std::mutex m_writeMutex;    // Innermost lock: guards the original buffers
+
+    Buffer& buffer(Stream stream);
+};
@@ -0,0 +1,169 @@
+#include "DpcProgress.h"
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+DpcProgress::DpcProgress(std::ostream& out)
+    : m_out(out), m_source(DpcOutput::currentSource()), m_active(false), m_stopping(false) {
+    // Redrawing a line with '\r' only makes sense on a terminal
+    m_terminal = (&out == &std::cout && isatty(fileno(stdout))) ||
+                    (&out == &std::cerr && isatty(fileno(stderr)));
+}
+
+DpcProgress::~DpcProgress() {
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+    if (m_renderer.joinable()) {
+        m_renderer.join();
+    }
+}
+
+void DpcProgress::update(const std::string& phase, size_t done, size_t total) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    if (!m_active || phase != m_current.phase) {
+        if (m_active) {
+            m_current.end = now;
+            m_completed.push_back(m_current);
+        }
+        m_current = Snapshot();
+        m_current.phase = phase;
+        m_current.start = now;
+        m_active = true;
+        if (!m_renderer.joinable()) {
+            m_renderer = std::thread(&DpcProgress::renderLoop, this);
+        }
+    }
+    m_current.done = (total > 0) ? std::min(done, total) : done;
+    m_current.total = total;
+}
+
+void DpcProgress::finish() {
+    render(true);
+}
+
+void DpcProgress::renderLoop() {
+    DpcOutput::Source source(m_source);
+    std::unique_lock<std::mutex> lock(m_stateMutex);
+    while (!m_wakeup.wait_for(lock, RENDER_INTERVAL, [this] { return m_stopping; })) {
+        lock.unlock();
+        render(false);
+        lock.lock();
+    }
+}
+
+void DpcProgress::render(bool final) {
+    // Take the numbers and let update() go on; the writing happens outside the state lock
+    std::lock_guard<std::mutex> output(m_outputMutex);
+    std::vector<Snapshot> completed;
+    Snapshot current;
+    bool active;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        completed.swap(m_completed);
+        current = m_current;
+        active = m_active;
+        if (final) {
+            m_active = false;
+        }
+    }
+
+    for (const auto& snapshot : completed) {
+        writeLine(snapshot, snapshot.end, true);
+    }
+    if (active) {
+        writeLine(current, Clock::now(), final);
+    }
+}
+
+void DpcProgress::writeLine(const Snapshot& snapshot, Clock::time_point now, bool final) {
+    std::string line = formatLine(snapshot, now);
+    if (!m_terminal || !DpcOutput::isDirect()) {
+        if (final) {
+            // One write, so a routed line cannot be split by another thread's output
+            m_out << line + "\n" << std::flush;
+        }
+        return;
+    }
+    if (line != m_lastLine) {
+        // Pad so a shorter line fully covers the previous one
+        m_out << "\r" << line << "   ";
+        m_lastLine = line;
+    }
+    if (final) {
+        m_out << std::endl;
+        m_lastLine.clear();
+    } else {
+        m_out << std::flush;
+    }
+}
+
+std::string DpcProgress::formatLine(const Snapshot& snapshot, Clock::time_point now) {
+    double seconds = std::chrono::duration<double>(now - snapshot.start).count();
+    std::ostringstream line;
+    line << std::left << std::setw(8) << snapshot.phase;
+    if (snapshot.total == 0) {
+        // Size unknown (e.g. erase): show that the phase is running and for how long
+        line << "... " << formatDuration(seconds);
+        return line.str();
+    }
+    size_t done = snapshot.done;
+    size_t total = snapshot.total;
+
+    int percent = static_cast<int>((done * 100) / total);
+    int pos = static_cast<int>((done * BAR_WIDTH) / total);
+    line << "[";
+    for (int i = 0; i < BAR_WIDTH; ++i) {
+        line << (i < pos ? '=' : (i == pos ? '>' : ' '));
+    }
+    line << "] " << std::right << std::setw(3) << percent << "% " << formatBytes(static_cast<double>(done)) << "/"
+         << formatBytes(static_cast<double>(total));
+
+    if (now - snapshot.start >= MIN_RATE_INTERVAL && done > 0) {
+        double rate = done / seconds;
+        line << "  " << formatBytes(rate) << "/s";
+        if (done < total) {
+            line << "  ETA " << formatDuration((total - done) / rate);
+        } else {
+            line << "  in " << formatDuration(seconds);
+        }
+    }
+    return line.str();
+}
+
+std::string DpcProgress::formatBytes(double bytes) {
+    std::ostringstream ss;
+    ss << std::fixed;
+    if (bytes >= 1024 * 1024) {
+        ss << std::setprecision(1) << bytes / (1024 * 1024) << " MB";
+    } else if (bytes >= 1024) {
+        ss << std::setprecision(1) << bytes / 1024 << " KB";
+    } else {
+        ss << std::setprecision(0) << bytes << " B";
+    }
+    return ss.str();
+}
+
+std::string DpcProgress::formatDuration(double seconds) {
+    std::ostringstream ss;
+    if (seconds < 60) {
+        ss << std::fixed << std::setprecision(1) << seconds << "s";
+    } else {
+        int whole = static_cast<int>(seconds);
+        ss << whole / 60 << "m" << std::setw(2) << std::setfill('0') << whole % 60 << "s";
+    }
+    return ss.str();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "DpcOutput.h"
+
+// Single-line progress bar with throughput and ETA, for transfers measured in bytes.
+// Each phase (e.g. "erase", "write", "verify") gets its own line.
+//
+// update() only records the numbers, so it is cheap to call from a transfer loop or a
+// network callback. A render thread samples them every RENDER_INTERVAL and writes the
+// line only when its text changed; a slow console or a pipe never holds up the caller.
+// When the output is not a terminal, or is routed elsewhere than the console (see
+// DpcOutput), only the final line of each phase is written. The render thread writes
+// with the output source of the thread that created the progress bar.
+class DpcProgress {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit DpcProgress(std::ostream& out = std::cout);
+    ~DpcProgress();
+    DpcProgress(const DpcProgress&) = delete;
+    DpcProgress& operator=(const DpcProgress&) = delete;
+
+    // Report progress of a phase; a new phase name ends the previous line. With total 0
+    // only the phase and its running time are shown.
+    void update(const std::string& phase, size_t done, size_t total);
+
+    // Draw the final state and end the current line (if any); nothing is written after
+    // this returns until the next update()
+    void finish();
+
+private:
+    struct Snapshot {
+        std::string phase;
+        size_t done = 0;
+        size_t total = 0;
+        Clock::time_point start;
+        Clock::time_point end;          // Set once the phase is over
+    };
+
+    std::ostream& m_out;
+    bool m_terminal;
+    DpcOutput::SourceId m_source;
+
+    // Written by update(), read by the render thread
+    std::mutex m_stateMutex;
+    Snapshot m_current;
+    bool m_active;
+    std::vector<Snapshot> m_completed;  // Phases ended since the last render
+
+    // Serializes the writes of the render thread and finish()
+    std::mutex m_outputMutex;
+    std::string m_lastLine;
+
+    std::thread m_renderer;
+    std::condition_variable m_wakeup;
+    bool m_stopping;
+
+    void renderLoop();
+    void render(bool final);
+    void writeLine(const Snapshot& snapshot, Clock::time_point now, bool final);
+    static std::string formatLine(const Snapshot& snapshot, Clock::time_point now);
+    static std::string formatBytes(double bytes);
+    static std::string formatDuration(double seconds);
+
+    static constexpr int BAR_WIDTH = 30;
+    static constexpr std::chrono::milliseconds RENDER_INTERVAL{100};
+    // Throughput and ETA are shown once the phase ran long enough to estimate them
+    static constexpr std::chrono::milliseconds MIN_RATE_INTERVAL{200};
+};
@@ -0,0 +1,192 @@
+// diyPresso Client SAM-BA Protocol - Platform support: macOS 13+ and Windows 10/11 only
+#include "DpcSamba.h"
+#include <iostream>
+#include <stdexcept>
+#include <cstdio>
+#include <algorithm>
+
+DpcSamba::DpcSamba(DpcSerial& serial) : serial_(serial), pending_copy_(false) {
+}
+
+void DpcSamba::connect(DpcSerial::Deadline deadline) {
+    // The bootloader may still be initialising USB right after enumeration, so retry
+    // the handshake instead of sleeping for a fixed time first
+    while (true) {
+        serial_.discard_input();
+        send("N#");
+        char reply[2];
+        auto attempt_deadline = std::min(deadline, DpcSerial::Clock::now() + std::chrono::milliseconds(250));
+        if (serial_.read_exact(reply, sizeof(reply), attempt_deadline) == DpcSerial::ReadStatus::Ok &&
+            reply[0] == '\n' && reply[1] == '\r') {
+            break;
+        }
+        if (DpcSerial::Clock::now() >= deadline) {
+            throw std::runtime_error("No response from bootloader");
+        }
+    }
+
+    // Version string ends with "\n\r"
+    send("V#");
+    version_.clear();
+    auto version_deadline = DpcSerial::Clock::now() + COMMAND_TIMEOUT;
+    char c;
+    while (version_.size() < 256) {
+        if (serial_.read_exact(&c, 1, version_deadline) != DpcSerial::ReadStatus::Ok) {
+            throw std::runtime_error("Timeout reading bootloader version");
+        }
+        if (c == '\r' && !version_.empty() && version_.back() == '\n') {
+            version_.pop_back();
+            break;
+        }
+        version_ += c;
+    }
+
+    extensions_.clear();
+    size_t tag = version_.find("[Arduino:");
+    if (tag != std::string::npos) {
+        size_t end = version_.find(']', tag);
+        extensions_ = version_.substr(tag + 9, end == std::string::npos ? std::string::npos : end - tag - 9);
+    }
+}
+
+const std::string& DpcSamba::get_version() const {
+    return version_;
+}
+
+bool DpcSamba::can_erase() const {
+    return extensions_.find('X') != std::string::npos;
+}
+
+bool DpcSamba::can_write_buffer() const {
+    return extensions_.find('Y') != std::string::npos;
+}
+
+bool DpcSamba::can_checksum() const {
+    return extensions_.find('Z') != std::string::npos;
+}
+
+uint32_t DpcSamba::read_word(uint32_t address) {
+    send(format_command('w', address, 4));
+    uint8_t bytes[4];
+    if (serial_.read_exact(bytes, sizeof(bytes), DpcSerial::Clock::now() + COMMAND_TIMEOUT) != DpcSerial::ReadStatus::Ok) {
+        throw std::runtime_error("Timeout reading word from bootloader");
+    }
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+void DpcSamba::write_word(uint32_t address, uint32_t value) {
+    send(format_command('W', address, value));
+}
+
+void DpcSamba::read_memory(uint32_t address, uint8_t* data, size_t size) {
+    // The bootloader mishandles USB reads of a power-of-two size above 32 bytes:
+    // read the first byte on its own, then the rest
+    if (size > 32 && (size & (size - 1)) == 0) {
+        read_memory(address, data, 1);
+        address += 1;
+        data += 1;
+        size -= 1;
+    }
+
+    send(format_command('R', address, static_cast<uint32_t>(size)));
+    if (serial_.read_exact(data, size, DpcSerial::Clock::now() + COMMAND_TIMEOUT) != DpcSerial::ReadStatus::Ok) {
+        throw std::runtime_error("Timeout reading memory from bootloader");
+    }
+}
+
+void DpcSamba::write_memory(uint32_t address, const uint8_t* data, size_t size) {
+    send(format_command('S', address, static_cast<uint32_t>(size)));
+
+    // The bootloader gets confused when command and data share a USB packet; drain the
+    // command first so the driver cannot combine the writes
+    serial_.drain();
+    if (!serial_.write_bytes(data, size, DpcSerial::Clock::now() + COMMAND_TIMEOUT)) {
+        throw std::runtime_error("Failed to write data to bootloader");
+    }
+}
+
+void DpcSamba::erase_from(uint32_t address) {
+    send(format_command('X', address));
+    expect_reply('X', FLASH_TIMEOUT);
+}
+
+void DpcSamba::copy_to_flash(uint32_t source, uint32_t destination, size_t size) {
+    start_copy_to_flash(source, destination, size);
+    finish_copy_to_flash();
+}
+
+void DpcSamba::start_copy_to_flash(uint32_t source, uint32_t destination, size_t size) {
+    send(format_command('Y', source, 0));
+    expect_reply('Y', COMMAND_TIMEOUT);
+    send(format_command('Y', destination, static_cast<uint32_t>(size)));
+    pending_copy_ = true;
+}
+
+void DpcSamba::finish_copy_to_flash() {
+    if (pending_copy_) {
+        pending_copy_ = false;
+        expect_reply('Y', FLASH_TIMEOUT);
+    }
+}
+
+uint16_t DpcSamba::checksum(uint32_t address, size_t size) {
+    send(format_command('Z', address, static_cast<uint32_t>(size)));
+
+    // "Z" + 8 hex digits + "#\n\r"
+    char reply[12];
+    if (serial_.read_exact(reply, sizeof(reply), DpcSerial::Clock::now() + FLASH_TIMEOUT) != DpcSerial::ReadStatus::Ok) {
+        throw std::runtime_error("Timeout waiting for checksum from bootloader");
+    }
+    if (reply[0] != 'Z') {
+        throw std::runtime_error("Unexpected checksum reply from bootloader");
+    }
+    return static_cast<uint16_t>(std::stoul(std::string(reply + 1, 8), nullptr, 16));
+}
+
+void DpcSamba::reset() {
+    write_word(AIRCR_ADDRESS, AIRCR_SYSRESETREQ);
+    serial_.drain();
+}
+
+uint16_t DpcSamba::crc16(const uint8_t* data, size_t size, uint16_t crc) {
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void DpcSamba::send(const std::string& command) {
+    if (serial_.is_verbose()) {
+        std::cout << "[SAMBA] " << command << std::endl;
+    }
+    if (!serial_.write_bytes(command.data(), command.size(), DpcSerial::Clock::now() + COMMAND_TIMEOUT)) {
+        throw std::runtime_error("Failed to send command to bootloader: " + command);
+    }
+}
+
+void DpcSamba::expect_reply(char command, std::chrono::milliseconds timeout) {
+    // Acknowledgement: the command letter followed by "\n\r"
+    char reply[3];
+    if (serial_.read_exact(reply, sizeof(reply), DpcSerial::Clock::now() + timeout) != DpcSerial::ReadStatus::Ok) {
+        throw std::runtime_error(std::string("Timeout waiting for bootloader to acknowledge ") + command + " command");
+    }
+    if (reply[0] != command) {
+        throw std::runtime_error(std::string("Unexpected bootloader reply to ") + command + " command");
+    }
+}
+
+std::string DpcSamba::format_command(char command, uint32_t address) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%c%08X#", command, address);
+    return buffer;
+}
+
+std::string DpcSamba::format_command(char command, uint32_t address, uint32_t argument) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%c%08X,%08X#", command, address, argument);
+    return buffer;
+}
@@ -0,0 +1,75 @@
+// diyPresso Client SAM-BA Protocol - Platform support: macOS 13+ and Windows 10/11 only
+#pragma once
+#include "DpcSerial.h"
+#include <string>
+#include <cstdint>
+#include <chrono>
+
+// SAM-BA monitor protocol as spoken by the Arduino SAMD21 bootloader, over an open
+// DpcSerial port in binary mode. Protocol failures (timeouts, unexpected replies)
+// throw std::runtime_error, like DpcDevice::send_command.
+//
+// Commands (addresses and sizes as 8 hex digits):
+//   N#                 switch to binary mode, reply "\n\r"
+//   V#                 version string, e.g. "v2.0 [Arduino:XYZ] ...\n\r"
+//   w<addr>,4#         read word          W<addr>,<value>#   write word
+//   R<addr>,<size>#    read memory        S<addr>,<size>#    write memory (data follows)
+//   X<addr>#           erase flash from addr to the end, reply "X\n\r"        (Arduino extension)
+//   Y<addr>,0#         set source buffer in RAM, reply "Y\n\r"                (Arduino extension)
+//   Y<addr>,<size>#    copy source buffer to flash at addr, reply "Y\n\r"     (Arduino extension)
+//   Z<addr>,<size>#    CRC16 of memory, reply "Z<crc>#\n\r"                   (Arduino extension)
+class DpcSamba {
+public:
+    explicit DpcSamba(DpcSerial& serial);
+
+    // Enter binary mode and read the version; retries until the bootloader answers
+    void connect(DpcSerial::Deadline deadline);
+    const std::string& get_version() const;
+
+    // Arduino extensions announced in the version string ("[Arduino:XYZ]")
+    bool can_erase() const;
+    bool can_write_buffer() const;
+    bool can_checksum() const;
+
+    uint32_t read_word(uint32_t address);
+    void write_word(uint32_t address, uint32_t value);
+    void read_memory(uint32_t address, uint8_t* data, size_t size);
+
+    // Write to RAM without waiting for a reply (S has none), so it can overlap
+    // with a flash write still in progress on the device
+    void write_memory(uint32_t address, const uint8_t* data, size_t size);
+
+    void erase_from(uint32_t address);
+    void copy_to_flash(uint32_t source, uint32_t destination, size_t size);
+
+    // Split variant of copy_to_flash for pipelining: send the command now, collect the reply later
+    void start_copy_to_flash(uint32_t source, uint32_t destination, size_t size);
+    void finish_copy_to_flash();
+
+    uint16_t checksum(uint32_t address, size_t size);
+
+    // Reset the MCU through the Cortex-M0+ AIRCR (SYSRESETREQ); the port goes away afterwards
+    void reset();
+
+    // Same CRC16 (CCITT, polynomial 0x1021, initial value 0) as the bootloader's Z command
+    static uint16_t crc16(const uint8_t* data, size_t size, uint16_t crc = 0);
+
+    // Per-command reply timeouts: flash erase and programming take longer than plain I/O
+    static constexpr std::chrono::milliseconds COMMAND_TIMEOUT{1000};
+    static constexpr std::chrono::milliseconds FLASH_TIMEOUT{10000};
+
+    // Cortex-M0+ Application Interrupt and Reset Control Register
+    static constexpr uint32_t AIRCR_ADDRESS = 0xE000ED0C;
+    static constexpr uint32_t AIRCR_SYSRESETREQ = 0x05FA0004;
+
+private:
+    DpcSerial& serial_;
+    std::string version_;
+    std::string extensions_;    // Letters from "[Arduino:...]"
+    bool pending_copy_;
+
+    void send(const std::string& command);
+    void expect_reply(char command, std::chrono::milliseconds timeout);
+    static std::string format_command(char command, uint32_t address);
+    static std::string format_command(char command, uint32_t address, uint32_t argument);
+};
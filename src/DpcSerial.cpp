@@ -1,5 +1,6 @@
 // diyPresso Client Serial - Platform support: macOS 13+ and Windows 10/11 only
 #include "DpcSerial.h"
+#include "DpcBaudrate.h"
 #include <iostream>
 #include <memory>
 #include <libusbp-1/libusbp.hpp>
@@ -11,16 +12,27 @@
     #include <fcntl.h>
     #include <unistd.h>
     #include <termios.h>
+    #include <poll.h>
+    #include <cerrno>
     #include <cstring>
 #endif
 #include <thread>
+#include <algorithm>
 
-DpcSerial::DpcSerial() : is_open_(false), verbose_(false) {
+DpcSerial::DpcSerial() 
+    : is_open_(false), verbose_(false), rx_buffer_(RX_BUFFER_SIZE), rx_slot_held_(false),
+      reader_stop_(false), reader_done_(false), reader_status_(ReadStatus::Ok),
+      consumer_waiting_(false), dropped_lines_(0) {
 #ifdef _WIN32
     handle_ = INVALID_HANDLE_VALUE;
+    read_timeout_ms_ = 0;
+    reader_handle_ = nullptr;
 #else
     fd_ = -1;
+    wake_pipe_[0] = -1;
+    wake_pipe_[1] = -1;
 #endif
+    reset_buffer();
 }
 
 DpcSerial::~DpcSerial() {
@@ -30,6 +42,21 @@ DpcSerial::~DpcSerial() {
 std::string DpcSerial::find_controller(bool& bootloader_mode) {
     bootloader_mode = false;
     
+    std::vector<ControllerInfo> controllers = list_controllers();
+    if (controllers.empty()) {
+        return "";
+    }
+    
+    const ControllerInfo& controller = controllers.front();
+    bootloader_mode = controller.bootloader_mode;
+    std::cout << "Found Arduino MKR WiFi 1010 on port: " << controller.port 
+              << " (bootloader: " << (bootloader_mode ? "yes" : "no") << ")" << std::endl;
+    return controller.port;
+}
+
+std::vector<DpcSerial::ControllerInfo> DpcSerial::list_controllers() {
+    std::vector<ControllerInfo> controllers;
+    
     try {
         // Get list of all connected USB devices
         std::vector<libusbp::device> devices = libusbp::list_connected_devices();
@@ -44,22 +71,35 @@ std::string DpcSerial::find_controller(bool& bootloader_mode) {
                 (product_id == ARDUINO_MKR_WIFI_1010_PRODUCT_ID || 
                  product_id == ARDUINO_MKR_WIFI_1010_PRODUCT_ID_BOOTLOADER)) {
                 
-                bootloader_mode = (product_id == ARDUINO_MKR_WIFI_1010_PRODUCT_ID_BOOTLOADER);
+                ControllerInfo controller;
+                controller.bootloader_mode = (product_id == ARDUINO_MKR_WIFI_1010_PRODUCT_ID_BOOTLOADER);
+                controller.vendor_id = vendor_id;
+                controller.product_id = product_id;
                 
                 // Create serial port object and get its name
                 try {
                     libusbp::serial_port serial_port(device);
-                    std::string port_name = serial_port.get_name();
-                    
-                    if (!port_name.empty()) {
-                        std::cout << "Found Arduino MKR WiFi 1010 on port: " << port_name 
-                                  << " (bootloader: " << (bootloader_mode ? "yes" : "no") << ")" << std::endl;
-                        return port_name;
-                    }
+                    controller.port = serial_port.get_name();
                 } catch (const libusbp::error& e) {
                     // Device might not have a serial port, continue to next device
                     continue;
                 }
+                if (controller.port.empty()) {
+                    continue;
+                }
+                
+                try {
+                    controller.serial_number = device.get_serial_number();
+                } catch (const libusbp::error& e) {
+                    // No serial number descriptor (e.g. some bootloaders)
+                }
+                try {
+                    controller.location = device.get_os_id();
+                } catch (const libusbp::error& e) {
+                    // Location is optional
+                }
+                
+                controllers.push_back(controller);
             }
         }
     } catch (const libusbp::error& e) {
@@ -68,12 +108,38 @@ std::string DpcSerial::find_controller(bool& bootloader_mode) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
     
-    return "";
+    // Enumeration order is up to the OS; keep listings and "first controller" stable
+    std::sort(controllers.begin(), controllers.end(),
+              [](const ControllerInfo& a, const ControllerInfo& b) { return a.port < b.port; });
+    return controllers;
+}
+
+std::vector<DpcSerial::ControllerInfo> DpcSerial::find_controllers(const std::string& selector) {
+    std::vector<ControllerInfo> controllers = list_controllers();
+    if (!selector.empty()) {
+        controllers.erase(std::remove_if(controllers.begin(), controllers.end(),
+                                         [&](const ControllerInfo& c) { return !c.matches(selector); }),
+                          controllers.end());
+    }
+    return controllers;
+}
+
+bool DpcSerial::ControllerInfo::matches(const std::string& selector) const {
+    if (selector.empty()) {
+        return false;
+    }
+    if (selector == port || selector == location || (!serial_number.empty() && selector == serial_number)) {
+        return true;
+    }
+    // Bare port name, e.g. "ttyACM0" for "/dev/ttyACM0"
+    size_t slash = port.find_last_of('/');
+    return slash != std::string::npos && selector == port.substr(slash + 1);
 }
 
 bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     // Close any existing connection first
     close();
+    last_error_.clear();
     
 #ifdef _WIN32
     // Windows implementation
@@ -91,6 +157,7 @@ bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     );
     
     if (handle_ == INVALID_HANDLE_VALUE) {
+        last_error_ = "cannot open port (error " + std::to_string(GetLastError()) + ")";
         return false;
     }
     
@@ -99,7 +166,8 @@ bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     dcb.DCBlength = sizeof(dcb);
     
     if (!GetCommState(handle_, &dcb)) {
-        close();
+        last_error_ = "cannot read port settings (error " + std::to_string(GetLastError()) + ")";
+        release_port();
         return false;
     }
     
@@ -122,20 +190,34 @@ bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     dcb.fAbortOnError = FALSE;
     
     if (!SetCommState(handle_, &dcb)) {
-        close();
+        last_error_ = "baud rate " + std::to_string(baudrate) + " not accepted by the driver";
+        release_port();
+        return false;
+    }
+    
+    // Verify the driver really runs at the requested rate
+    DCB applied = {};
+    applied.DCBlength = sizeof(applied);
+    if (!GetCommState(handle_, &applied) || applied.BaudRate != baudrate) {
+        last_error_ = "baud rate " + std::to_string(baudrate) + " not supported (driver reports " +
+                      std::to_string(applied.BaudRate) + ")";
+        release_port();
         return false;
     }
     
-    // Set timeouts
+    // Set timeouts: ReadFile returns as soon as any byte is available,
+    // or after ReadTotalTimeoutConstant ms if nothing arrives (see fill_buffer)
+    read_timeout_ms_ = 100;
     COMMTIMEOUTS timeouts = {};
     timeouts.ReadIntervalTimeout = MAXDWORD;
-    timeouts.ReadTotalTimeoutConstant = 0;
-    timeouts.ReadTotalTimeoutMultiplier = 0;
+    timeouts.ReadTotalTimeoutConstant = read_timeout_ms_;
+    timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
     timeouts.WriteTotalTimeoutConstant = 1000;
     timeouts.WriteTotalTimeoutMultiplier = 0;
     
     if (!SetCommTimeouts(handle_, &timeouts)) {
-        close();
+        last_error_ = "cannot set port timeouts (error " + std::to_string(GetLastError()) + ")";
+        release_port();
         return false;
     }
     
@@ -143,12 +225,14 @@ bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     // macOS implementation
     fd_ = ::open(port.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (fd_ == -1) {
+        last_error_ = std::string("cannot open port: ") + strerror(errno);
         return false;
     }
     
     // Save original settings
     if (tcgetattr(fd_, &original_termios_) != 0) {
-        close();
+        last_error_ = std::string("cannot read port settings: ") + strerror(errno);
+        release_port();
         return false;
     }
     
@@ -156,20 +240,21 @@ bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     memset(&tty, 0, sizeof(tty));
     
     if (tcgetattr(fd_, &tty) != 0) {
-        close();
+        last_error_ = std::string("cannot read port settings: ") + strerror(errno);
+        release_port();
         return false;
     }
     
-    // Set baud rate
+    // Set baud rate: standard rates via termios, anything else through DpcBaudrate after tcsetattr
     speed_t speed;
-    switch (baudrate) {
-        case 1200:   speed = B1200; break;
-        case 9600:   speed = B9600; break;
-        case 19200:  speed = B19200; break;
-        case 38400:  speed = B38400; break;
-        case 57600:  speed = B57600; break;
-        case 115200: speed = B115200; break;
-        default:     speed = B115200; break;
+    bool custom_speed = !standard_speed(baudrate, speed);
+    if (custom_speed) {
+        if (!DpcBaudrate::supports_custom()) {
+            last_error_ = "unsupported baud rate " + std::to_string(baudrate);
+            release_port();
+            return false;
+        }
+        speed = B9600; // Placeholder, replaced below
     }
     
     cfsetispeed(&tty, speed);
@@ -194,7 +279,23 @@ bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     tty.c_cc[VTIME] = 0;
     
     if (tcsetattr(fd_, TCSANOW, &tty) != 0) {
-        close();
+        last_error_ = std::string("cannot configure port: ") + strerror(errno);
+        release_port();
+        return false;
+    }
+    
+    if (custom_speed && !DpcBaudrate::set_custom(fd_, baudrate)) {
+        last_error_ = "baud rate " + std::to_string(baudrate) + " not accepted by the driver";
+        release_port();
+        return false;
+    }
+    
+    // Verify the driver really runs at the requested rate
+    unsigned int actual = 0;
+    if (DpcBaudrate::get_actual(fd_, actual) && actual != baudrate) {
+        last_error_ = "baud rate " + std::to_string(baudrate) + " not supported (driver reports " +
+                      std::to_string(actual) + ")";
+        release_port();
         return false;
     }
     
@@ -202,6 +303,7 @@ bool DpcSerial::open(const std::string& port, unsigned int baudrate) {
     tcflush(fd_, TCIOFLUSH);
 #endif
     
+    reset_buffer();
     is_open_ = true;
     return true;
 }
@@ -210,58 +312,394 @@ bool DpcSerial::is_open() const {
     return is_open_;
 }
 
+std::string DpcSerial::get_last_error() const {
+    return last_error_;
+}
+
+#ifndef _WIN32
+bool DpcSerial::standard_speed(unsigned int baudrate, speed_t& speed) {
+    switch (baudrate) {
+        case 1200:   speed = B1200; return true;
+        case 9600:   speed = B9600; return true;
+        case 19200:  speed = B19200; return true;
+        case 38400:  speed = B38400; return true;
+        case 57600:  speed = B57600; return true;
+        case 115200: speed = B115200; return true;
+#ifdef B230400
+        case 230400: speed = B230400; return true;
+#endif
+#ifdef B460800
+        case 460800: speed = B460800; return true;
+#endif
+#ifdef B921600
+        case 921600: speed = B921600; return true;
+#endif
+        default:     return false;
+    }
+}
+#endif
+
+void DpcSerial::release_port() {
+#ifdef _WIN32
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+}
+
 std::string DpcSerial::readline() {
-    if (!is_open_) return "";
-    
     std::string line;
-    char c;
+    readline(line, NO_DEADLINE);
+    return line;
+}
+
+DpcSerial::ReadStatus DpcSerial::readline(std::string& line, Deadline deadline) {
+    line.clear();
     
-#ifdef _WIN32
-    DWORD bytes_read;
+    const char* data;
+    size_t size;
+    ReadStatus status = read_raw_line(data, size, deadline);
+    if (status == ReadStatus::Ok) {
+        line.assign(data, size);
+    }
+    return status;
+}
+
+DpcSerial::ReadStatus DpcSerial::readline(std::string_view& line, Deadline deadline) {
+    line = std::string_view();
     
+    const char* data;
+    size_t size;
+    ReadStatus status = read_raw_line(data, size, deadline);
+    if (status == ReadStatus::Ok) {
+        line = trim_line_ending(std::string_view(data, size));
+    }
+    return status;
+}
+
+std::string_view DpcSerial::trim_line_ending(std::string_view line) {
+    if (!line.empty() && line.back() == '\n') {
+        line.remove_suffix(1);
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+DpcSerial::ReadStatus DpcSerial::read_raw_line(const char*& data, size_t& size, Deadline deadline) {
+    if (!is_open_) return ReadStatus::Closed;
+    
+    ReadStatus status = rx_queue_ ? read_line_from_queue(data, size, deadline)
+                                  : read_line_from_port(data, size, deadline);
+    if (status != ReadStatus::Ok) {
+        return status;
+    }
+    
+    if (verbose_ && size > 0) {
+        std::cout << "[RECV] " << trim_line_ending(std::string_view(data, size)) << std::endl;
+    }
+    
+    return ReadStatus::Ok;
+}
+
+DpcSerial::ReadStatus DpcSerial::read_line_from_port(const char*& data, size_t& size, Deadline deadline) {
     while (true) {
-        if (!ReadFile(handle_, &c, 1, &bytes_read, nullptr) || bytes_read == 0) {
-            // Wait a bit for data
-            Sleep(1);
-            continue;
+        // Look for a complete line in the buffered data
+        const char* begin = rx_buffer_.data();
+        const char* newline = static_cast<const char*>(
+            memchr(begin + rx_scan_, '\n', rx_tail_ - rx_scan_));
+        
+        if (newline) {
+            size_t end = static_cast<size_t>(newline - begin) + 1;
+            data = begin + rx_head_;
+            size = end - rx_head_;
+            rx_head_ = end;
+            rx_scan_ = end;
+            return ReadStatus::Ok;
         }
+        rx_scan_ = rx_tail_;
         
-        line += c;
-        if (c == '\n') {
-            break;
+        // Buffer full without a newline: grow it, or hand out the oversized line as-is
+        if (rx_head_ == 0 && rx_tail_ == rx_buffer_.size()) {
+            if (rx_buffer_.size() < RX_BUFFER_MAX_SIZE) {
+                rx_buffer_.resize(rx_buffer_.size() * 2);
+            } else {
+                // The bytes stay in place until the next fill, which is after the caller is done
+                data = begin;
+                size = rx_tail_;
+                reset_buffer();
+                return ReadStatus::Ok;
+            }
+        }
+        
+        ReadStatus status = fill_buffer(deadline);
+        if (status != ReadStatus::Ok) {
+            return status;
         }
     }
-#else
+}
+
+DpcSerial::ReadStatus DpcSerial::read_line_from_queue(const char*& data, size_t& size, Deadline deadline) {
+    // The slot handed out by the previous call is no longer referenced by the caller
+    if (rx_slot_held_) {
+        rx_queue_->pop();
+        rx_slot_held_ = false;
+    }
+    
     while (true) {
-        ssize_t result = ::read(fd_, &c, 1);
-        if (result > 0) {
-            line += c;
-            if (c == '\n') {
-                break;
-            }
-        } else if (result == 0) {
-            // No data available, wait a bit
-            usleep(1000); // 1ms
+        if (std::string* queued = rx_queue_->front()) {
+            data = queued->data();
+            size = queued->size();
+            rx_slot_held_ = true;
+            return ReadStatus::Ok;
+        }
+        if (reader_done_.load()) {
+            return reader_status_.load();
+        }
+        
+        // Queue empty: sleep until the reader thread signals a new line or the deadline passes
+        std::unique_lock<std::mutex> lock(rx_wait_mutex_);
+        consumer_waiting_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto ready = [this] { return !rx_queue_->empty() || reader_done_.load(); };
+        bool woken = true;
+        if (deadline == NO_DEADLINE) {
+            rx_wait_cv_.wait(lock, ready);
         } else {
-            // Error
-            break;
+            woken = rx_wait_cv_.wait_until(lock, deadline, ready);
+        }
+        consumer_waiting_.store(false);
+        
+        if (!woken) {
+            return ReadStatus::Timeout;
         }
     }
+}
+
+bool DpcSerial::start_reader(size_t queue_capacity) {
+    if (!is_open_) return false;
+    if (rx_queue_) return true;
+    
+#ifndef _WIN32
+    if (::pipe(wake_pipe_) != 0) {
+        last_error_ = std::string("cannot create reader wakeup pipe: ") + strerror(errno);
+        wake_pipe_[0] = -1;
+        wake_pipe_[1] = -1;
+        return false;
+    }
+    for (int fd : wake_pipe_) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+    }
+#endif
+    rx_queue_ = std::make_unique<DpcLineQueue>(queue_capacity);
+    rx_slot_held_ = false;
+    reader_stop_.store(false);
+    reader_done_.store(false);
+    reader_status_.store(ReadStatus::Ok);
+    dropped_lines_.store(0);
+    reader_thread_ = std::thread(&DpcSerial::reader_loop, this);
+    return true;
+}
+
+void DpcSerial::stop_reader() {
+    if (!rx_queue_) return;
+    
+    reader_stop_.store(true);
+    wake_reader();
+    if (reader_thread_.joinable()) {
+        reader_thread_.join();
+    }
+#ifdef _WIN32
+    if (HANDLE thread = reader_handle_.exchange(nullptr)) {
+        CloseHandle(thread);
+    }
+#else
+    ::close(wake_pipe_[0]);
+    ::close(wake_pipe_[1]);
+    wake_pipe_[0] = -1;
+    wake_pipe_[1] = -1;
 #endif
     
-    if (verbose_ && !line.empty()) {
-        std::string display_line = line;
-        // Remove newline for display
-        if (!display_line.empty() && display_line.back() == '\n') {
-            display_line.pop_back();
+    // Lines still queued are discarded together with the queue
+    rx_queue_.reset();
+    rx_slot_held_ = false;
+}
+
+bool DpcSerial::is_reader_running() const {
+    return rx_queue_ && !reader_done_.load();
+}
+
+size_t DpcSerial::get_dropped_lines() const {
+    return dropped_lines_.load();
+}
+
+void DpcSerial::wake_reader() {
+#ifdef _WIN32
+    // Abort the reader's pending ReadFile. Retried until the reader is gone, because a
+    // cancel that lands between two reads has no effect.
+    while (!reader_done_.load()) {
+        if (HANDLE thread = reader_handle_.load()) {
+            CancelSynchronousIo(thread);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#else
+    // The reader polls the read end next to the port and returns as soon as it is readable
+    char wake = 0;
+    (void)!::write(wake_pipe_[1], &wake, 1);
+#endif
+}
+
+void DpcSerial::reader_loop() {
+#ifdef _WIN32
+    HANDLE thread = nullptr;
+    if (DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &thread,
+                        0, FALSE, DUPLICATE_SAME_ACCESS)) {
+        reader_handle_.store(thread);
+    }
+#endif
+    const char* data;
+    size_t size;
+    while (!reader_stop_.load()) {
+#ifdef _WIN32
+        // stop_reader() cancels the read; the slice bounds the wait should a cancel be missed
+        ReadStatus status = read_line_from_port(data, size, Clock::now() + READER_POLL_INTERVAL);
+#else
+        // stop_reader() wakes the poll through the self-pipe, reported as a timeout
+        ReadStatus status = read_line_from_port(data, size, NO_DEADLINE);
+#endif
+        if (status == ReadStatus::Timeout) {
+            continue;
         }
-        if (!display_line.empty() && display_line.back() == '\r') {
-            display_line.pop_back();
+        if (status != ReadStatus::Ok) {
+            reader_status_.store(status);
+            break;
+        }
+        
+        if (!rx_queue_->try_push(data, size)) {
+            dropped_lines_.fetch_add(1);
         }
-        std::cout << "[RECV] " << display_line << std::endl;
+        notify_consumer();
     }
     
-    return line;
+    reader_done_.store(true);
+    notify_consumer();
+}
+
+void DpcSerial::notify_consumer() {
+    // Only take the lock when the consumer is (about to be) asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_waiting_.load()) {
+        std::lock_guard<std::mutex> lock(rx_wait_mutex_);
+        rx_wait_cv_.notify_one();
+    }
+}
+
+DpcSerial::ReadStatus DpcSerial::fill_buffer(Deadline deadline) {
+    // Drop consumed data: reset when empty, otherwise move the partial line to the front
+    if (rx_head_ == rx_tail_) {
+        reset_buffer();
+    } else if (rx_tail_ == rx_buffer_.size() && rx_head_ > 0) {
+        memmove(rx_buffer_.data(), rx_buffer_.data() + rx_head_, rx_tail_ - rx_head_);
+        rx_tail_ -= rx_head_;
+        rx_scan_ -= rx_head_;
+        rx_head_ = 0;
+    }
+    
+    char* dest = rx_buffer_.data() + rx_tail_;
+    size_t space = rx_buffer_.size() - rx_tail_;
+    
+    while (true) {
+        // Remaining time until the deadline, rounded up to whole milliseconds
+        long long timeout_ms = -1;
+        if (deadline != NO_DEADLINE) {
+            auto remaining = deadline - Clock::now();
+            if (remaining <= Clock::duration::zero()) {
+                return ReadStatus::Timeout;
+            }
+            timeout_ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+        }
+        
+#ifdef _WIN32
+        // With ReadIntervalTimeout and ReadTotalTimeoutMultiplier at MAXDWORD, ReadFile returns
+        // as soon as data is available or after ReadTotalTimeoutConstant ms without data.
+        // Infinite waits are split into 1 s slices.
+        DWORD wait_ms = (timeout_ms < 0) ? 1000 : static_cast<DWORD>(std::min<long long>(timeout_ms, 1000));
+        if (wait_ms != read_timeout_ms_) {
+            COMMTIMEOUTS timeouts = {};
+            timeouts.ReadIntervalTimeout = MAXDWORD;
+            timeouts.ReadTotalTimeoutConstant = wait_ms;
+            timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+            timeouts.WriteTotalTimeoutConstant = 1000;
+            timeouts.WriteTotalTimeoutMultiplier = 0;
+            if (!SetCommTimeouts(handle_, &timeouts)) {
+                return ReadStatus::Error;
+            }
+            read_timeout_ms_ = wait_ms;
+        }
+        
+        DWORD bytes_read = 0;
+        if (!ReadFile(handle_, dest, static_cast<DWORD>(space), &bytes_read, nullptr)) {
+            DWORD error = GetLastError();
+            return (error == ERROR_ACCESS_DENIED || error == ERROR_BAD_COMMAND || error == ERROR_OPERATION_ABORTED)
+                ? ReadStatus::Closed : ReadStatus::Error;
+        }
+        if (bytes_read > 0) {
+            rx_tail_ += bytes_read;
+            return ReadStatus::Ok;
+        }
+#else
+        // The wakeup pipe is only open in background reader mode; poll() skips a negative fd
+        struct pollfd pfds[2];
+        pfds[0].fd = fd_;
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+        pfds[1].fd = wake_pipe_[0];
+        pfds[1].events = POLLIN;
+        pfds[1].revents = 0;
+        
+        int poll_ms = (timeout_ms < 0) ? -1 : static_cast<int>(std::min<long long>(timeout_ms, 60000));
+        int ready = ::poll(pfds, 2, poll_ms);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return ReadStatus::Error;
+        }
+        if (pfds[1].revents != 0) {
+            return ReadStatus::Timeout;   // Woken by stop_reader()
+        }
+        if (ready == 0) {
+            continue; // Deadline (or a 60 s slice) elapsed, re-evaluated at loop start
+        }
+        
+        ssize_t result = ::read(fd_, dest, space);
+        if (result > 0) {
+            rx_tail_ += static_cast<size_t>(result);
+            return ReadStatus::Ok;
+        }
+        if (result < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue;
+        }
+        // Readable but no data, or EIO: the device hung up
+        if (result == 0 || errno == EIO) {
+            return ReadStatus::Closed;
+        }
+        return ReadStatus::Error;
+#endif
+    }
+}
+
+void DpcSerial::reset_buffer() {
+    rx_head_ = 0;
+    rx_tail_ = 0;
+    rx_scan_ = 0;
 }
 
 void DpcSerial::write(const std::string& data) {
@@ -291,9 +729,108 @@ void DpcSerial::write(const std::string& data) {
 #endif
 }
 
+bool DpcSerial::write_bytes(const void* data, size_t size, Deadline deadline) {
+    if (!is_open_) return false;
+    
+    const char* next = static_cast<const char*>(data);
+    size_t remaining = size;
+    while (remaining > 0) {
+        if (deadline != NO_DEADLINE && Clock::now() >= deadline) {
+            return false;
+        }
+#ifdef _WIN32
+        DWORD bytes_written = 0;
+        if (!WriteFile(handle_, next, static_cast<DWORD>(remaining), &bytes_written, nullptr)) {
+            if (verbose_) {
+                std::cerr << "Write failed: " << GetLastError() << std::endl;
+            }
+            return false;
+        }
+        next += bytes_written;
+        remaining -= bytes_written;
+#else
+        ssize_t result = ::write(fd_, next, remaining);
+        if (result > 0) {
+            next += result;
+            remaining -= static_cast<size_t>(result);
+            continue;
+        }
+        if (result < 0 && errno != EAGAIN && errno != EINTR) {
+            return false;
+        }
+        
+        // Output buffer full (non-blocking port): wait until it drains
+        struct pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        int poll_ms = 1000;
+        if (deadline != NO_DEADLINE) {
+            poll_ms = static_cast<int>(std::max<long long>(0, std::min<long long>(1000,
+                std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count())));
+        }
+        if (::poll(&pfd, 1, poll_ms) < 0 && errno != EINTR) {
+            return false;
+        }
+        if (pfd.revents & (POLLERR | POLLHUP)) {
+            return false;
+        }
+#endif
+    }
+    return true;
+}
+
+DpcSerial::ReadStatus DpcSerial::read_exact(void* data, size_t size, Deadline deadline) {
+    if (!is_open_) return ReadStatus::Closed;
+    if (rx_queue_) return ReadStatus::Error;    // The reader thread owns the port
+    
+    char* dest = static_cast<char*>(data);
+    while (size > 0) {
+        // Serve buffered bytes first, then read more
+        size_t available = rx_tail_ - rx_head_;
+        if (available > 0) {
+            size_t count = std::min(available, size);
+            memcpy(dest, rx_buffer_.data() + rx_head_, count);
+            dest += count;
+            size -= count;
+            rx_head_ += count;
+            rx_scan_ = std::max(rx_scan_, rx_head_);
+            continue;
+        }
+        
+        ReadStatus status = fill_buffer(deadline);
+        if (status != ReadStatus::Ok) {
+            return status;
+        }
+    }
+    return ReadStatus::Ok;
+}
+
+void DpcSerial::drain() {
+    if (!is_open_) return;
+#ifdef _WIN32
+    FlushFileBuffers(handle_);
+#else
+    tcdrain(fd_);
+#endif
+}
+
+void DpcSerial::discard_input() {
+    if (!is_open_) return;
+    if (rx_queue_) return;      // The reader thread owns the port and the receive buffer
+    reset_buffer();
+#ifdef _WIN32
+    PurgeComm(handle_, PURGE_RXCLEAR);
+#else
+    tcflush(fd_, TCIFLUSH);
+#endif
+}
+
 void DpcSerial::close() {
     if (!is_open_) return;
     
+    stop_reader();
+    
 #ifdef _WIN32
     if (handle_ != INVALID_HANDLE_VALUE) {
         CloseHandle(handle_);
@@ -313,6 +850,7 @@ void DpcSerial::close() {
     }
 #endif
     
+    reset_buffer();
     is_open_ = false;
 }
 
@@ -325,9 +863,18 @@ bool DpcSerial::is_verbose() const {
 }
 
 // Static utility methods for simple operations
-std::unique_ptr<DpcSerial> DpcSerial::create_and_connect(unsigned int baudrate) {
-    bool bootloader_mode;
-    std::string port = find_controller(bootloader_mode);
+std::unique_ptr<DpcSerial> DpcSerial::create_and_connect(unsigned int baudrate, const std::string& selector) {
+    std::string port;
+    if (selector.empty()) {
+        bool bootloader_mode;
+        port = find_controller(bootloader_mode);
+    } else {
+        std::vector<ControllerInfo> controllers = find_controllers(selector);
+        if (!controllers.empty()) {
+            port = controllers.front().port;
+            std::cout << "Found Arduino MKR WiFi 1010 on port: " << port << std::endl;
+        }
+    }
     
     if (port.empty()) {
         return nullptr;
@@ -335,16 +882,17 @@ std::unique_ptr<DpcSerial> DpcSerial::create_and_connect(unsigned int baudrate)
     
     auto serial = std::make_unique<DpcSerial>();
     if (!serial->open(port, baudrate)) {
+        std::cerr << "Failed to open serial port: " << port << " (" << serial->get_last_error() << ")" << std::endl;
         return nullptr;
     }
     
     return serial;
 }
 
-bool DpcSerial::simple_monitor(bool verbose) {
+bool DpcSerial::simple_monitor(bool verbose, unsigned int baudrate, const std::string& selector) {
     std::cout << "Searching for diyPresso device..." << std::endl;
     
-    auto serial = create_and_connect();
+    auto serial = create_and_connect(baudrate, selector);
     if (!serial) {
         std::cerr << "Failed to find or connect to diyPresso device" << std::endl;
         return false;
@@ -355,15 +903,15 @@ bool DpcSerial::simple_monitor(bool verbose) {
     std::cout << "Monitoring serial output. Press Ctrl+C to exit." << std::endl;
     std::cout << std::endl;
     
+    // Block until data arrives; no periodic wakeups while the device is idle
+    std::string_view line;
     while (true) {
-        if (serial->is_open()) {
-            std::string line = serial->readline();
-            if (!line.empty()) {
-                // Print without extra newline since readline() includes it
-                std::cout << line << std::flush;
-            }
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        DpcSerial::ReadStatus status = serial->readline(line, NO_DEADLINE);
+        if (status == DpcSerial::ReadStatus::Ok) {
+            std::cout << line << '\n' << std::flush;
+        } else if (status != DpcSerial::ReadStatus::Timeout) {
+            std::cerr << std::endl << "Serial connection lost" << std::endl;
+            return false;
         }
     }
     
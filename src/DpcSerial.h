@@ -1,8 +1,16 @@
 // diyPresso Client Serial - Platform support: macOS 13+ and Windows 10/11 only
 #pragma once
 #include <string>
+#include <string_view>
 #include <memory>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <libusbp-1/libusbp.hpp>
+#include "DpcLineQueue.h"
 
 #ifdef _WIN32
     #include <windows.h>
@@ -12,6 +20,19 @@
 
 class DpcSerial {
 public:
+    // Deadline-based timing for all blocking reads
+    using Clock = std::chrono::steady_clock;
+    using Deadline = Clock::time_point;
+    static constexpr Deadline NO_DEADLINE = Deadline::max();
+
+    // Result of a deadline-bounded read
+    enum class ReadStatus {
+        Ok,         // A complete line was read
+        Timeout,    // Deadline passed before a complete line arrived
+        Closed,     // Port is not open or the device went away
+        Error       // Read error reported by the OS
+    };
+
     // Constructor and destructor
     DpcSerial();
     ~DpcSerial();
@@ -20,21 +41,58 @@ public:
     DpcSerial(const DpcSerial&) = delete;
     DpcSerial& operator=(const DpcSerial&) = delete;
 
+    // An attached MKR WiFi 1010 controller (application or bootloader)
+    struct ControllerInfo {
+        std::string port;
+        std::string serial_number;  // USB serial number, empty if the device reports none
+        std::string location;       // OS device identifier (libusbp os_id); on Linux the USB port path
+        bool bootloader_mode;
+        uint16_t vendor_id;
+        uint16_t product_id;
+
+        // Selector: port name (with or without "/dev/"), USB serial number or location
+        bool matches(const std::string& selector) const;
+    };
+
     // Static methods
-    static std::string find_controller(bool& bootloader_mode);
+    static std::string find_controller(bool& bootloader_mode);  // First controller found
+    static std::vector<ControllerInfo> list_controllers();      // All controllers, ordered by port
+    static std::vector<ControllerInfo> find_controllers(const std::string& selector);  // Empty selector: all
     
     // Static utility methods for simple operations
-    static std::unique_ptr<DpcSerial> create_and_connect(unsigned int baudrate = 115200);
-    static bool simple_monitor(bool verbose = false);
+    static std::unique_ptr<DpcSerial> create_and_connect(unsigned int baudrate = 115200, const std::string& selector = "");
+    static bool simple_monitor(bool verbose = false, unsigned int baudrate = 115200, const std::string& selector = "");
     static bool reset_to_bootloader(const std::string& port, bool verbose = false);
 
     // Instance methods
     bool open(const std::string& port, unsigned int baudrate = 115200);
     bool is_open() const;
-    std::string readline();
+    std::string get_last_error() const;   // Reason for the last failed open()
+    std::string readline();                                     // Blocks until a line arrives or the port fails
+    ReadStatus readline(std::string& line, Deadline deadline);  // Copy of the line including '\n'
+    
+    // Zero-copy framing: 'line' (without CR/LF) points into the port's receive buffer and is
+    // only valid until the next read or close on this port. Use retain() to keep it longer.
+    ReadStatus readline(std::string_view& line, Deadline deadline);
+    static std::string retain(std::string_view line) { return std::string(line); }
+    static std::string_view trim_line_ending(std::string_view line);
+    
     void write(const std::string& data);
     void close();
     
+    // Binary transfers (bootloader protocol). Not available in background reader mode.
+    bool write_bytes(const void* data, size_t size, Deadline deadline);   // All bytes, or false
+    ReadStatus read_exact(void* data, size_t size, Deadline deadline);     // Exactly size bytes
+    void drain();           // Block until written data has left the host (tcdrain)
+    void discard_input();   // Drop buffered and not yet read input
+    
+    // Background reader mode: a dedicated thread frames incoming lines into a lock-free
+    // queue and readline() consumes from it, so the port is drained while the caller is busy
+    bool start_reader(size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+    void stop_reader();
+    bool is_reader_running() const;
+    size_t get_dropped_lines() const;   // Lines lost because the queue was full
+    
     // Verbose mode
     void set_verbose(bool verbose);
     bool is_verbose() const;
@@ -44,13 +102,56 @@ public:
     static constexpr int ARDUINO_MKR_WIFI_1010_PRODUCT_ID = 32852;
     static constexpr int ARDUINO_MKR_WIFI_1010_PRODUCT_ID_BOOTLOADER = 84;
 
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 4096;
+
 private:
 #ifdef _WIN32
     HANDLE handle_;
+    DWORD read_timeout_ms_;     // Currently configured ReadTotalTimeoutConstant
 #else
     int fd_;
     struct termios original_termios_;
+    
+    static bool standard_speed(unsigned int baudrate, speed_t& speed);
 #endif
+    std::string last_error_;
+    void release_port();    // Close a port that failed configuration in open()
     bool is_open_;
     bool verbose_;
+
+    // Receive buffer: filled with large reads, lines are framed from [rx_head_, rx_tail_)
+    static constexpr size_t RX_BUFFER_SIZE = 4096;
+    static constexpr size_t RX_BUFFER_MAX_SIZE = 65536;
+    std::vector<char> rx_buffer_;
+    size_t rx_head_;
+    size_t rx_tail_;
+    size_t rx_scan_;    // Bytes before this offset are known to contain no '\n'
+
+    ReadStatus fill_buffer(Deadline deadline);
+    void reset_buffer();
+    ReadStatus read_raw_line(const char*& data, size_t& size, Deadline deadline);
+    ReadStatus read_line_from_port(const char*& data, size_t& size, Deadline deadline);
+    
+    // Background reader state
+#ifdef _WIN32
+    static constexpr std::chrono::milliseconds READER_POLL_INTERVAL{200};   // Fallback if a cancel is missed
+    std::atomic<HANDLE> reader_handle_;     // Reader thread, so stop_reader() can cancel its ReadFile
+#else
+    int wake_pipe_[2];                      // Self-pipe: stop_reader() wakes the reader's poll()
+#endif
+    std::unique_ptr<DpcLineQueue> rx_queue_;
+    bool rx_slot_held_;                     // Front slot is lent out to the caller as a view
+    std::thread reader_thread_;
+    std::atomic<bool> reader_stop_;
+    std::atomic<bool> reader_done_;         // Reader exited; reader_status_ tells why
+    std::atomic<ReadStatus> reader_status_;
+    std::atomic<bool> consumer_waiting_;
+    std::atomic<size_t> dropped_lines_;
+    std::mutex rx_wait_mutex_;
+    std::condition_variable rx_wait_cv_;
+    
+    void reader_loop();
+    void wake_reader();
+    void notify_consumer();
+    ReadStatus read_line_from_queue(const char*& data, size_t& size, Deadline deadline);
 }; 
\ No newline at end of file
@@ -12,7 +12,7 @@ DpcSettings::DpcSettings() {}
 
 DpcSettings::~DpcSettings() {}
 
-DpcSettings::Settings DpcSettings::get_settings(DpcDevice& device) {
+DpcSettings::Settings DpcSettings::get_settings(DpcDevice& device, int timeout_seconds) {
     if (!device.is_connected()) {
         throw std::runtime_error("Device not connected");
     }
@@ -49,7 +49,7 @@ DpcSettings::Settings DpcSettings::get_settings(DpcDevice& device) {
     }
 
     // Send GET settings command and wait for response (1.6.2+ firmware)
-    auto lines = device.send_command("GET settings", 5);
+    auto lines = device.send_command("GET settings", timeout_seconds);
     Settings settings = parse_settings_response(lines);
     
     // Check for commissioning status using boot sequence (available for all firmware)
@@ -61,7 +61,7 @@ DpcSettings::Settings DpcSettings::get_settings(DpcDevice& device) {
     return settings;
 }
 
-bool DpcSettings::put_settings(DpcDevice& device, const Settings& settings) {
+bool DpcSettings::put_settings(DpcDevice& device, const Settings& settings, int timeout_seconds) {
     if (!device.is_connected()) {
         throw std::runtime_error("Device not connected");
     }
@@ -80,7 +80,7 @@ bool DpcSettings::put_settings(DpcDevice& device, const Settings& settings) {
     std::string command = "PUT settings " + settings_string;
 
     try {
-        auto lines = device.send_command(command, 5);
+        auto lines = device.send_command(command, timeout_seconds);
         
         // If send_command returned without exception, the command was successful
         // (send_command already checked for "PUT settings OK" start)
@@ -148,8 +148,10 @@ bool DpcSettings::backup_current_settings(DpcDevice& device, std::string& backup
             return false;
         }
         
-        // Generate filename and save settings to backup file
-        backup_filename = generate_default_filename();
+        // Generate filename (unless the caller chose one) and save settings to backup file
+        if (backup_filename.empty()) {
+            backup_filename = generate_default_filename();
+        }
         if (!save_to_file(currentSettings, backup_filename)) {
             return false;
         }
@@ -14,15 +14,16 @@ public:
     DpcSettings();
     ~DpcSettings();
 
-    // Settings operations (requires connected device)
-    Settings get_settings(DpcDevice& device);
-    bool put_settings(DpcDevice& device, const Settings& settings);
+    // Settings operations (requires connected device); each protocol wait is bounded by timeout_seconds
+    Settings get_settings(DpcDevice& device, int timeout_seconds = DEFAULT_TIMEOUT_SECONDS);
+    bool put_settings(DpcDevice& device, const Settings& settings, int timeout_seconds = DEFAULT_TIMEOUT_SECONDS);
 
     // File I/O operations
     bool save_to_file(const Settings& settings, const std::string& filename = "");
     Settings load_from_file(const std::string& filename);
     
     // High-level operations for firmware upload workflow
+    // backup_filename: file to write (empty: settings_<timestamp>.json); set to the file written
     bool backup_current_settings(DpcDevice& device, std::string& backup_filename);
     bool restore_settings_from_backup(DpcDevice& device, const std::string& backup_filename);
 
@@ -31,6 +32,8 @@ public:
     size_t get_settings_count(const Settings& settings);
     void print_settings(const Settings& settings);
 
+    static constexpr int DEFAULT_TIMEOUT_SECONDS = 5;
+
 private:
     // Helper methods
     std::string generate_default_filename();
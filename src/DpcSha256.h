@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Streaming SHA-256 (FIPS 180-4), for content-addressing firmware images without
+// pulling in a crypto library. Feed data with update() as it arrives, then hexDigest().
+class DpcSha256 {
+public:
+    DpcSha256();
+
+    void update(const void* data, size_t size);
+    void update(const std::string& data);
+    // Add a file's contents; false if it cannot be read
+    bool updateFile(const std::string& path);
+
+    // Lowercase hex digest; ends the computation (call reset() to start over)
+    std::string hexDigest();
+    void reset();
+
+    static std::string hash(const std::string& data);
+    // Digest of a file's contents; empty if it cannot be read
+    static std::string hashFile(const std::string& path);
+
+private:
+    uint32_t m_state[8];
+    uint8_t m_block[64];
+    size_t m_blockSize;
+    uint64_t m_totalBytes;
+
+    void transform(const uint8_t* block);
+};
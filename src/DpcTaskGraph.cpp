@@ -0,0 +1,241 @@
+#include "DpcTaskGraph.h"
+#include "DpcColors.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+// No task: no console owner, or a thread outside the graph
+const size_t NO_TASK = DpcOutput::NO_SOURCE;
+
+std::string formatSeconds(DpcTaskGraph::Clock::duration duration) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1)
+       << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() / 1000.0 << "s";
+    return ss.str();
+}
+
+} // namespace
+
+// Routes console output while the graph runs: the console owner and threads outside
+// the graph write through, other tasks into their held-back buffer
+class DpcTaskGraph::ConsoleRouter : public DpcOutput::Router {
+public:
+    explicit ConsoleRouter(DpcTaskGraph& graph) : m_graph(graph) {
+    }
+
+    void write(DpcOutput& output, DpcOutput::Stream stream, DpcOutput::SourceId source,
+               const char* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(m_graph.m_mutex);
+        if (source != NO_TASK && source != m_graph.m_consoleOwner) {
+            auto& held = (stream == DpcOutput::Stream::Out) ? m_graph.m_heldOut : m_graph.m_heldErr;
+            held[source].append(data, size);
+        } else {
+            output.write(stream, data, size);
+        }
+    }
+
+    bool isDirect(DpcOutput::SourceId source) override {
+        std::lock_guard<std::mutex> lock(m_graph.m_mutex);
+        return source == NO_TASK || source == m_graph.m_consoleOwner;
+    }
+
+private:
+    DpcTaskGraph& m_graph;
+};
+
+DpcTaskGraph::DpcTaskGraph()
+    : m_running(0), m_failed(false), m_consoleOwner(NO_TASK), m_output(nullptr) {
+}
+
+DpcTaskGraph::TaskId DpcTaskGraph::addTask(const std::string& name, Action action, const std::vector<TaskId>& dependencies) {
+    for (TaskId dependency : dependencies) {
+        if (dependency >= m_tasks.size()) {
+            throw std::invalid_argument("Task " + name + " depends on a task that was not added before it");
+        }
+    }
+    Task task;
+    task.name = name;
+    task.action = std::move(action);
+    task.dependencies = dependencies;
+    m_tasks.push_back(std::move(task));
+    return m_tasks.size() - 1;
+}
+
+bool DpcTaskGraph::run() {
+    m_heldOut.assign(m_tasks.size(), std::string());
+    m_heldErr.assign(m_tasks.size(), std::string());
+    m_runStart = Clock::now();
+
+    std::vector<std::thread> threads;
+    {
+        ConsoleRouter router(*this);
+        DpcOutput output(router);
+        m_output = &output;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            // Start every task whose dependencies all succeeded
+            for (TaskId id = 0; id < m_tasks.size() && !m_failed; ++id) {
+                Task& task = m_tasks[id];
+                bool ready = !task.started && std::all_of(task.dependencies.begin(), task.dependencies.end(),
+                                                          [&](TaskId dep) { return m_tasks[dep].succeeded; });
+                if (ready) {
+                    task.started = true;
+                    task.startTime = Clock::now();
+                    if (m_consoleOwner == NO_TASK) {
+                        m_consoleOwner = id;
+                    }
+                    ++m_running;
+                    threads.emplace_back(&DpcTaskGraph::runTask, this, id);
+                }
+            }
+            if (m_running == 0) {
+                break;
+            }
+            m_finished.wait(lock);
+        }
+        lock.unlock();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        m_output = nullptr;
+    }
+
+    return std::all_of(m_tasks.begin(), m_tasks.end(), [](const Task& task) { return task.succeeded; });
+}
+
+void DpcTaskGraph::runTask(TaskId id) {
+    bool ok = false;
+    {
+        DpcOutput::Source source(id);
+        try {
+            ok = m_tasks[id].action();
+        } catch (const std::exception& e) {
+            std::cerr << DpcColors::error(m_tasks[id].name + " failed: " + e.what()) << std::endl;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Task& task = m_tasks[id];
+    task.endTime = Clock::now();
+    task.finished = true;
+    task.succeeded = ok;
+    if (!ok) {
+        m_failed = true;
+    }
+    releaseConsole(id);
+    --m_running;
+    m_finished.notify_one();
+}
+
+void DpcTaskGraph::releaseConsole(TaskId id) {
+    if (m_consoleOwner != id) {
+        // Finished while another task had the console: write its output now
+        writeHeld(id);
+        return;
+    }
+
+    // Hand the console to the longest-running remaining task
+    m_consoleOwner = NO_TASK;
+    for (TaskId other = 0; other < m_tasks.size(); ++other) {
+        const Task& task = m_tasks[other];
+        if (task.started && !task.finished &&
+            (m_consoleOwner == NO_TASK || task.startTime < m_tasks[m_consoleOwner].startTime)) {
+            m_consoleOwner = other;
+        }
+    }
+    if (m_consoleOwner != NO_TASK) {
+        writeHeld(m_consoleOwner);
+    }
+}
+
+void DpcTaskGraph::writeHeld(TaskId id) {
+    // Called with m_mutex held; each stream's held output starts on a fresh line
+    auto write = [&](DpcOutput::Stream stream, std::string& held) {
+        if (!held.empty()) {
+            m_output->write(stream, held.data(), held.size(), true);
+            m_output->flush(stream);
+            held.clear();
+        }
+    };
+    write(DpcOutput::Stream::Out, m_heldOut[id]);
+    write(DpcOutput::Stream::Err, m_heldErr[id]);
+}
+
+const std::vector<DpcTaskGraph::Task>& DpcTaskGraph::getTasks() const {
+    return m_tasks;
+}
+
+std::vector<DpcTaskGraph::TaskId> DpcTaskGraph::criticalPath() const {
+    // Start from the task that finished last, then follow the dependency that finished last
+    std::vector<TaskId> path;
+    TaskId current = NO_TASK;
+    for (TaskId id = 0; id < m_tasks.size(); ++id) {
+        if (m_tasks[id].finished && (current == NO_TASK || m_tasks[id].endTime > m_tasks[current].endTime)) {
+            current = id;
+        }
+    }
+    while (current != NO_TASK) {
+        path.push_back(current);
+        TaskId gating = NO_TASK;
+        for (TaskId dep : m_tasks[current].dependencies) {
+            if (gating == NO_TASK || m_tasks[dep].endTime > m_tasks[gating].endTime) {
+                gating = dep;
+            }
+        }
+        current = gating;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+void DpcTaskGraph::printCriticalPath(std::ostream& out) const {
+    std::vector<TaskId> path = criticalPath();
+    if (path.empty()) {
+        return;
+    }
+    Clock::time_point end = m_tasks[path.back()].endTime;
+
+    out << "Critical path (" << formatSeconds(end - m_runStart) << " total):" << std::endl;
+    for (TaskId id : path) {
+        const Task& task = m_tasks[id];
+        out << "  " << std::left << std::setw(16) << task.name << std::right << std::setw(7)
+            << formatSeconds(task.endTime - task.startTime);
+        if (!task.succeeded) {
+            out << "  FAILED";
+        }
+        out << std::endl;
+    }
+
+    bool headerPrinted = false;
+    for (TaskId id = 0; id < m_tasks.size(); ++id) {
+        const Task& task = m_tasks[id];
+        if (!task.started || std::find(path.begin(), path.end(), id) != path.end()) {
+            continue;
+        }
+        if (!headerPrinted) {
+            out << "Overlapped:" << std::endl;
+            headerPrinted = true;
+        }
+        // Slack: how much longer the task could have taken without delaying anything
+        Clock::duration slack = end - task.endTime;
+        for (const Task& dependent : m_tasks) {
+            if (dependent.started &&
+                std::find(dependent.dependencies.begin(), dependent.dependencies.end(), id) != dependent.dependencies.end()) {
+                slack = std::min(slack, dependent.startTime - task.endTime);
+            }
+        }
+        out << "  " << std::left << std::setw(16) << task.name << std::right << std::setw(7)
+            << formatSeconds(task.endTime - task.startTime) << "  (slack " << formatSeconds(slack) << ")";
+        if (!task.succeeded) {
+            out << "  FAILED";
+        }
+        out << std::endl;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <ostream>
+#include "DpcOutput.h"
+
+// Runs a small graph of workflow steps: each task starts on its own thread as soon as
+// all tasks it depends on have succeeded, so independent steps (e.g. firmware download
+// and settings backup) overlap. After a failure no further tasks are started.
+//
+// While tasks run concurrently, one of them writes to std::cout/std::cerr directly and
+// the output of the others is held back (routed by DpcOutput, tagged with the task id)
+// and written in one piece when they finish.
+class DpcTaskGraph {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TaskId = size_t;
+    using Action = std::function<bool()>;   // false (or an exception) fails the task
+
+    struct Task {
+        std::string name;
+        Action action;
+        std::vector<TaskId> dependencies;
+        bool started = false;
+        bool finished = false;
+        bool succeeded = false;
+        Clock::time_point startTime;
+        Clock::time_point endTime;
+    };
+
+    DpcTaskGraph();
+
+    // Dependencies must have been added before
+    TaskId addTask(const std::string& name, Action action, const std::vector<TaskId>& dependencies = {});
+
+    // Run until all tasks finished or one failed; true if every task succeeded
+    bool run();
+
+    const std::vector<Task>& getTasks() const;
+
+    // The chain of tasks that determined the total time, with the time each spent
+    // waiting for its last dependency; other tasks are listed as overlapped
+    void printCriticalPath(std::ostream& out) const;
+
+private:
+    class ConsoleRouter;
+    friend class ConsoleRouter;
+
+    std::vector<Task> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_finished;
+    size_t m_running;
+    bool m_failed;
+    Clock::time_point m_runStart;
+
+    // Task writing directly to the console (none: npos)
+    size_t m_consoleOwner;
+    // Held-back output per task, for stdout and stderr
+    std::vector<std::string> m_heldOut;
+    std::vector<std::string> m_heldErr;
+    DpcOutput* m_output;
+
+    void runTask(TaskId id);
+    void releaseConsole(TaskId id);
+    void writeHeld(TaskId id);
+    std::vector<TaskId> criticalPath() const;
+};
@@ -0,0 +1,52 @@
+// diyPresso Client Timing - Platform support: macOS 13+ and Windows 10/11 only
+#include "DpcTiming.h"
+
+const DpcTiming::Entry& DpcTiming::record(const std::string& label, Clock::time_point start, Status status) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+    entries_.push_back(Entry{label, elapsed, status});
+    return entries_.back();
+}
+
+void DpcTiming::append(const DpcTiming& other) {
+    entries_.insert(entries_.end(), other.entries_.begin(), other.entries_.end());
+}
+
+const std::vector<DpcTiming::Entry>& DpcTiming::entries() const {
+    return entries_;
+}
+
+std::chrono::milliseconds DpcTiming::total() const {
+    std::chrono::milliseconds sum{0};
+    for (const auto& entry : entries_) {
+        sum += entry.elapsed;
+    }
+    return sum;
+}
+
+void DpcTiming::clear() {
+    entries_.clear();
+}
+
+void DpcTiming::print(std::ostream& out) const {
+    for (const auto& entry : entries_) {
+        print_entry(out, entry);
+    }
+}
+
+void DpcTiming::print_entry(std::ostream& out, const Entry& entry) {
+    out << "  " << entry.label << ": " << entry.elapsed.count() << " ms";
+    switch (entry.status) {
+    case Status::Completed:
+        break;
+    case Status::Timeout:
+        out << " [timeout]";
+        break;
+    case Status::Closed:
+        out << " [closed]";
+        break;
+    case Status::Error:
+        out << " [error]";
+        break;
+    }
+    out << std::endl;
+}
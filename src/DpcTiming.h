@@ -0,0 +1,43 @@
+// diyPresso Client Timing - Platform support: macOS 13+ and Windows 10/11 only
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ostream>
+
+// Records how long each protocol wait or workflow phase took
+class DpcTiming {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // How a wait ended
+    enum class Status {
+        Completed,
+        Timeout,    // Ran into its deadline
+        Closed,     // Connection closed or device went away
+        Error       // Failed: I/O error, exception or non-zero exit code
+    };
+
+    struct Entry {
+        std::string label;
+        std::chrono::milliseconds elapsed;
+        Status status;
+    };
+
+    // Record a wait that started at 'start' and ends now
+    const Entry& record(const std::string& label, Clock::time_point start, Status status);
+
+    // Add the entries of another record (e.g. the phases of a subprocess) after these
+    void append(const DpcTiming& other);
+
+    const std::vector<Entry>& entries() const;
+    std::chrono::milliseconds total() const;
+    void clear();
+
+    // Print one line per entry: "  <label>: <ms> ms [timeout|closed|error]"
+    void print(std::ostream& out) const;
+    static void print_entry(std::ostream& out, const Entry& entry);
+
+private:
+    std::vector<Entry> entries_;
+};
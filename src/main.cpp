@@ -1,6 +1,7 @@
 // diyPresso Client C++ - Platform support: macOS 13+ and Windows 10/11 only
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #include <CLI/CLI.hpp>
 #include <chrono>
 #include <thread>
@@ -10,7 +11,11 @@
 #include "DpcSettings.h"
 #include "DpcFirmware.h"
 #include "DpcDownload.h"
+#include "DpcDelta.h"
+#include "DpcBundle.h"
 #include "DpcColors.h"
+#include "DpcHotplug.h"
+#include "DpcFleet.h"
 
 const std::string VERSION = "1.0.0";
 
@@ -18,6 +23,8 @@ const std::string VERSION = "1.0.0";
 DpcDevice* g_device = nullptr;
 volatile bool g_interrupted = false;
 bool g_verbose = false;
+std::string g_device_selector = "";
+unsigned int g_baudrate = 115200;
 
 void signal_handler(int signal) {
     g_interrupted = true;
@@ -32,14 +39,44 @@ void signal_handler(int signal) {
     }
 }
 
+void print_controller_list(const std::vector<DpcSerial::ControllerInfo>& controllers) {
+    std::cout << "  " << std::left << std::setw(16) << "PORT" << std::setw(12) << "MODE"
+              << std::setw(20) << "SERIAL" << "LOCATION" << std::endl;
+    for (const auto& controller : controllers) {
+        std::cout << "  " << std::left << std::setw(16) << controller.port
+                  << std::setw(12) << (controller.bootloader_mode ? "bootloader" : "application")
+                  << std::setw(20) << (controller.serial_number.empty() ? "-" : controller.serial_number)
+                  << (controller.location.empty() ? "-" : controller.location) << std::endl;
+    }
+}
+
+bool check_single_controller() {
+    auto controllers = DpcSerial::list_controllers();
+    if (controllers.size() <= 1) {
+        return true;
+    }
+    std::cerr << DpcColors::error("Multiple diyPresso controllers found. Select one with --device <port|serial|location>:") << std::endl;
+    print_controller_list(controllers);
+    return false;
+}
+
 bool wait_for_device_connection(DpcDevice& device) {
     // Set verbose mode first so it's used during firmware detection
     device.set_verbose(g_verbose);
+    device.set_device_selector(g_device_selector);
     
     std::cout << "Searching for diyPresso device..." << std::endl;
     
+    // Never pick one of several controllers by accident
+    if (g_device_selector.empty() && !check_single_controller()) {
+        return false;
+    }
+    
+    // Watch for device nodes from the start, so a device plugged in during the first scan is seen
+    DpcHotplug hotplug;
+    
     // Try immediate connection first
-    if (device.find_and_connect()) {
+    if (device.find_and_connect(g_baudrate)) {
         return true;
     }
     
@@ -49,29 +86,40 @@ bool wait_for_device_connection(DpcDevice& device) {
     std::cout << "Waiting for device connection... (Ctrl+C to cancel)" << std::endl;
     
     const int timeout_seconds = 30;
-    const int check_interval_ms = 500;
-    const int max_attempts = (timeout_seconds * 1000) / check_interval_ms;
+    
+    // Rescan when a serial device node appears (timed rescans where events are unavailable)
+    auto now = DpcSerial::Clock::now();
+    auto deadline = now + std::chrono::seconds(timeout_seconds);
+    auto next_dot = now;
     
     int dots_printed = 0;
-    for (int attempt = 0; attempt < max_attempts && !g_interrupted; ++attempt) {
+    while (!g_interrupted) {
         // Print progress dots
-        if (attempt % 2 == 0) { // Every second (2 * 500ms)
+        if (DpcSerial::Clock::now() >= next_dot) { // Every second
             std::cout << "." << std::flush;
             dots_printed++;
             if (dots_printed >= 50) { // New line every 50 dots
                 std::cout << std::endl;
                 dots_printed = 0;
             }
+            next_dot += std::chrono::seconds(1);
+        }
+        
+        // Wait for a device change, the next dot or the timeout
+        bool rescan = hotplug.wait_for_change(std::min(next_dot, deadline));
+        if (g_interrupted) {
+            break;
         }
         
         // Check for device
-        if (device.find_and_connect()) {
+        if (rescan && device.find_and_connect(g_baudrate)) {
             std::cout << std::endl << DpcColors::ok("Device connected!") << std::endl;
             return true;
         }
         
-        // Wait before next attempt
-        std::this_thread::sleep_for(std::chrono::milliseconds(check_interval_ms));
+        if (DpcSerial::Clock::now() >= deadline) {
+            break;
+        }
     }
     
     if (g_interrupted) {
@@ -85,13 +133,35 @@ bool wait_for_device_connection(DpcDevice& device) {
     return false;
 }
 
+void check_baudrate_option() {
+    // Opening the MKR's USB port at 1200 baud is the bootloader reset signal
+    if (g_baudrate == 1200) {
+        std::cerr << DpcColors::error("1200 baud is reserved: it resets the controller into bootloader mode") << std::endl;
+        std::exit(1);
+    }
+}
+
 void print_device_info(const DpcDevice::DeviceInfo& info) {
     std::cout << "Device Information:" << std::endl;
     std::cout << "  Port: " << info.port << " (VID: " << info.vendor_id << ", PID: " << info.product_id << ")" << std::endl;
+    if (!info.serial_number.empty()) {
+        std::cout << "  Serial Number: " << info.serial_number << std::endl;
+    }
+    if (g_verbose && !info.location.empty()) {
+        std::cout << "  Location: " << info.location << std::endl;
+    }
     std::cout << "  In bootloader mode: " << (info.bootloader_mode ? "true" : "false") << std::endl;
     std::cout << "  Firmware Version: " << info.firmware_version << std::endl;
 }
 
+void print_wait_timings(const DpcDevice& device) {
+    if (!g_verbose || device.get_wait_timings().entries().empty()) {
+        return;
+    }
+    std::cout << "Protocol wait timings:" << std::endl;
+    device.get_wait_timings().print(std::cout);
+}
+
 void check_bootloader_mode_error(const DpcDevice& device) {
     if (device.is_in_bootloader_mode()) {
         std::cerr << "\n" << DpcColors::error("The diyPresso is in bootloader mode. The requested action requires the device to be in normal mode.") << std::endl;
@@ -101,6 +171,42 @@ void check_bootloader_mode_error(const DpcDevice& device) {
     }
 }
 
+// plan: flasher backend and options chosen on the command line
+void upload_fleet(DpcFirmware::UploadPlan plan, const std::string& firmware_path, const std::string& bossac_path,
+                  const std::string& version, const std::string& binary_url, size_t jobs, bool offline,
+                  const std::string& source) {
+    auto controllers = DpcSerial::find_controllers(g_device_selector);
+    if (controllers.empty()) {
+        std::cerr << DpcColors::error("No diyPresso controllers found.") << std::endl;
+        std::exit(1);
+    }
+    std::cout << "Found " << controllers.size() << " diyPresso controller" << (controllers.size() == 1 ? "" : "s") << ":" << std::endl;
+    print_controller_list(controllers);
+    
+    try {
+        std::cout << DpcColors::highlight("=== diyPresso Fleet Firmware Upload ===") << std::endl;
+        
+        // Download and check once for all devices
+        DpcFirmware firmware_uploader(g_verbose);
+        firmware_uploader.setOffline(offline);
+        firmware_uploader.setSource(source);
+        if (!firmware_uploader.prepareUpload(plan, firmware_path, bossac_path, version, binary_url)) {
+            std::cerr << DpcColors::error("Firmware upload failed!") << std::endl;
+            std::exit(1);
+        }
+        
+        DpcFleet fleet(g_verbose, jobs);
+        bool all_succeeded = fleet.uploadFirmware(controllers, plan);
+        fleet.printSummary(std::cout);
+        if (!all_succeeded) {
+            std::exit(1);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << DpcColors::error("Error during firmware upload: " + std::string(e.what())) << std::endl;
+        std::exit(1);
+    }
+}
+
 int main(int argc, char** argv) {
     // Set up signal handling
     std::signal(SIGINT, signal_handler);
@@ -119,7 +225,10 @@ int main(int argc, char** argv) {
     // Info command
     auto info_cmd = app.add_subcommand("info", "Print device info from the diyPresso machine");
     info_cmd->add_flag("-v,--verbose", g_verbose, "Enable verbose mode");
+    info_cmd->add_option("-d,--device", g_device_selector, "Device to use when several are connected: port, USB serial number or location (see list-devices)");
+    info_cmd->add_option("--baudrate", g_baudrate, "Serial baud rate, e.g. 115200, 230400, 460800, 921600 or any rate the driver accepts (default: 115200)");
     info_cmd->callback([&]() {
+        check_baudrate_option();
         if (!wait_for_device_connection(device)) {
             std::exit(1);
         }
@@ -128,13 +237,32 @@ int main(int argc, char** argv) {
 
         auto info = device.get_device_info();
         print_device_info(info);
+        print_wait_timings(device);
+    });
+
+    // List devices command
+    auto list_devices_cmd = app.add_subcommand("list-devices", "List all connected diyPresso controllers");
+    list_devices_cmd->callback([&]() {
+        auto controllers = DpcSerial::list_controllers();
+        if (controllers.empty()) {
+            std::cout << "No diyPresso controllers found." << std::endl;
+            return;
+        }
+        std::cout << "Found " << controllers.size() << " diyPresso controller" << (controllers.size() == 1 ? "" : "s") << ":" << std::endl;
+        print_controller_list(controllers);
     });
 
     // Monitor command
     auto monitor_cmd = app.add_subcommand("monitor", "Monitor the serial output from the diyPresso");
     monitor_cmd->add_flag("-v,--verbose", g_verbose, "Enable verbose mode");
+    monitor_cmd->add_option("-d,--device", g_device_selector, "Device to use when several are connected: port, USB serial number or location (see list-devices)");
+    monitor_cmd->add_option("--baudrate", g_baudrate, "Serial baud rate, e.g. 115200, 230400, 460800, 921600 or any rate the driver accepts (default: 115200)");
     monitor_cmd->callback([&]() {
-        if (!DpcSerial::simple_monitor(g_verbose)) {
+        check_baudrate_option();
+        if (g_device_selector.empty() && !check_single_controller()) {
+            std::exit(1);
+        }
+        if (!DpcSerial::simple_monitor(g_verbose, g_baudrate, g_device_selector)) {
             std::exit(1);
         }
     });
@@ -142,7 +270,10 @@ int main(int argc, char** argv) {
     // Get settings command
     auto get_settings_cmd = app.add_subcommand("get-settings", "Print the settings from the diyPresso");
     get_settings_cmd->add_flag("-v,--verbose", g_verbose, "Enable verbose mode");
+    get_settings_cmd->add_option("-d,--device", g_device_selector, "Device to use when several are connected: port, USB serial number or location (see list-devices)");
+    get_settings_cmd->add_option("--baudrate", g_baudrate, "Serial baud rate, e.g. 115200, 230400, 460800, 921600 or any rate the driver accepts (default: 115200)");
     get_settings_cmd->callback([&]() {
+        check_baudrate_option();
         if (!wait_for_device_connection(device)) {
             std::exit(1);
         }
@@ -160,12 +291,15 @@ int main(int argc, char** argv) {
                 std::cout << "\nSettings retrieved and saved successfully." << std::endl;
             }
             
+            print_wait_timings(device);
+            
             // Validate settings
             if (!settings_manager.validate_settings(settings)) {
                 std::cerr << "Settings validation failed." << std::endl;
                 std::exit(1);
             }
         } catch (const std::exception& e) {
+            print_wait_timings(device);
             std::cerr << "Error getting settings: " << e.what() << std::endl;
             std::exit(1);
         }
@@ -175,8 +309,11 @@ int main(int argc, char** argv) {
     std::string settings_file = "";
     auto restore_settings_cmd = app.add_subcommand("restore-settings", "Restore the settings to the diyPresso");
     restore_settings_cmd->add_flag("-v,--verbose", g_verbose, "Enable verbose mode");
+    restore_settings_cmd->add_option("-d,--device", g_device_selector, "Device to use when several are connected: port, USB serial number or location (see list-devices)");
+    restore_settings_cmd->add_option("--baudrate", g_baudrate, "Serial baud rate, e.g. 115200, 230400, 460800, 921600 or any rate the driver accepts (default: 115200)");
     restore_settings_cmd->add_option("--settings-file", settings_file, "Specify the path to the settings file")->required();
     restore_settings_cmd->callback([&]() {
+        check_baudrate_option();
         if (!wait_for_device_connection(device)) {
             std::exit(1);
         }
@@ -194,7 +331,9 @@ int main(int argc, char** argv) {
             }
             
             std::cout << "Restoring settings to device..." << std::endl;
-            if (settings_manager.put_settings(device, settings)) {
+            bool restored = settings_manager.put_settings(device, settings);
+            print_wait_timings(device);
+            if (restored) {
                 std::cout << "Settings restored successfully." << std::endl;
             } else {
                 std::cerr << "Failed to restore settings." << std::endl;
@@ -211,13 +350,51 @@ int main(int argc, char** argv) {
     std::string bossac_path = "";
     std::string upload_version = "latest";
     std::string upload_binary_url = "";
+    bool upload_all_devices = false;
+    size_t upload_jobs = DpcFleet::DEFAULT_JOBS;
+    std::string upload_flasher = "";
+    size_t upload_block_size = DpcFlasher::MAX_BLOCK_SIZE;
+    bool upload_full_erase = false;
+    bool upload_paranoid_verify = false;
+    bool upload_offline = false;
+    std::string upload_source = "";
     auto upload_cmd = app.add_subcommand("upload-firmware", "Upload firmware to the diyPresso controller");
     upload_cmd->add_flag("-v,--verbose", g_verbose, "Enable verbose mode");
+    upload_cmd->add_option("-d,--device", g_device_selector, "Device to use when several are connected: port, USB serial number or location (see list-devices)");
     upload_cmd->add_option("-b,--binary-file", firmware_path, "Skip download and use provided firmware binary file");
     upload_cmd->add_option("--bossac-file", bossac_path, "Specify the path to the bossac tool");
     upload_cmd->add_option("--version", upload_version, "Specific version/tag to download (default: latest)");
     upload_cmd->add_option("--binary-url", upload_binary_url, "Custom URL to download firmware from");
+    upload_cmd->add_flag("--all-devices", upload_all_devices, "Upload to all connected controllers (or all matching --device) in parallel");
+    upload_cmd->add_option("-j,--jobs", upload_jobs, "Maximum number of devices uploaded in parallel with --all-devices (default: 4)");
+    upload_cmd->add_option("--flasher", upload_flasher, "Flashing backend: native (built-in SAM-BA, default) or bossac (default with --bossac-file)");
+    upload_cmd->add_option("--flash-block-size", upload_block_size, "Native flasher transfer size in bytes, multiple of 64 up to 4096 (default: 4096)");
+    upload_cmd->add_flag("--full-erase", upload_full_erase, "Native flasher: erase and write the whole application area instead of only the rows that changed");
+    upload_cmd->add_flag("--paranoid-verify", upload_paranoid_verify, "Native flasher: verify by reading the whole image back instead of comparing checksums");
+    upload_cmd->add_flag("--offline", upload_offline, "Use only the local firmware cache, no network access");
+    upload_cmd->add_option("--source", upload_source, "Firmware source: github (default), a firmware bundle file (see create-bundle), a mirror directory or file:// URL, or an http(s):// mirror URL");
     upload_cmd->callback([&]() {
+        DpcFirmware::UploadPlan flash_options;
+        if (upload_flasher.empty()) {
+            upload_flasher = bossac_path.empty() ? "native" : "bossac";
+        }
+        if (upload_flasher != "native" && upload_flasher != "bossac") {
+            std::cerr << DpcColors::error("Unknown flasher: " + upload_flasher + " (use native or bossac)") << std::endl;
+            std::exit(1);
+        }
+        flash_options.flasher = (upload_flasher == "bossac") ? DpcFirmware::Flasher::Bossac : DpcFirmware::Flasher::Native;
+        flash_options.flashOptions.block_size = upload_block_size;
+        flash_options.flashOptions.delta = !upload_full_erase;
+        if (upload_paranoid_verify) {
+            flash_options.flashOptions.verify = DpcFlasher::Verify::ReadBack;
+        }
+        
+        if (upload_all_devices) {
+            upload_fleet(flash_options, firmware_path, bossac_path, upload_version, upload_binary_url, upload_jobs,
+                         upload_offline, upload_source);
+            return;
+        }
+        
         if (!wait_for_device_connection(device)) {
             std::exit(1);
         }
@@ -225,6 +402,9 @@ int main(int argc, char** argv) {
         try {
             // Create firmware uploader
             DpcFirmware firmware_uploader(g_verbose);
+            firmware_uploader.setFlasher(flash_options.flasher, flash_options.flashOptions);
+            firmware_uploader.setOffline(upload_offline);
+            firmware_uploader.setSource(upload_source);
             
             if (!firmware_uploader.uploadFirmware(&device, firmware_path, bossac_path, upload_version, upload_binary_url)) {
                 std::cerr << DpcColors::error("Firmware upload failed!") << std::endl;
@@ -242,17 +422,25 @@ int main(int argc, char** argv) {
     std::string download_output = "";
     bool check_version = false;
     bool list_versions = false;
-    auto download_cmd = app.add_subcommand("download", "Download firmware from GitHub");
+    bool download_offline = false;
+    std::string download_source = "";
+    auto download_cmd = app.add_subcommand("download", "Download firmware from GitHub or a mirror");
     download_cmd->add_flag("-v,--verbose", g_verbose, "Enable verbose mode");
     download_cmd->add_option("--version", download_version, "Specific version/tag to download or check.");
     download_cmd->add_option("--binary-url", download_url, "Custom URL to download firmware from");
     download_cmd->add_option("-o,--output", download_output, "Output file path (default: firmware.bin)");
     download_cmd->add_flag("--check", check_version, "Show firmware version information (use with --version for specific version, defaults to latest version)");
     download_cmd->add_flag("--list-versions", list_versions, "List all available firmware versions");
+    download_cmd->add_flag("--offline", download_offline, "Use only the local cache for release information and firmware");
+    download_cmd->add_option("--source", download_source, "Firmware source: github (default), a firmware bundle file (see create-bundle), a mirror directory or file:// URL, or an http(s):// mirror URL");
     download_cmd->callback([&]() {
         try {
             // Create download manager
             DpcDownload downloader(g_verbose);
+            downloader.setOffline(download_offline);
+            if (!downloader.setSource(download_source)) {
+                std::exit(1);
+            }
             
             // Handle check version
             if (check_version) {
@@ -260,13 +448,13 @@ int main(int argc, char** argv) {
                 
                 if (download_version == "latest") {
                     std::cout << DpcColors::highlight("=== Latest Firmware Information ===") << std::endl;
-                    target_version = downloader.getLatestVersionTag();
-                    if (target_version.empty()) {
-                        std::cerr << DpcColors::error("Failed to get latest version from GitHub") << std::endl;
+                    // One request for both the tag and the release details
+                    auto release_info = downloader.getLatestRelease();
+                    if (!release_info.contains("tag_name")) {
+                        std::cerr << DpcColors::error("Failed to get latest version from " + downloader.getSourceName()) << std::endl;
                         std::exit(1);
                     }
-                    
-                    auto release_info = downloader.getLatestRelease();
+                    target_version = release_info["tag_name"].get<std::string>();
                     std::cout << "Latest version: " << target_version << std::endl;
                     
                     if (release_info.contains("published_at")) {
@@ -301,7 +489,7 @@ int main(int argc, char** argv) {
                 std::cout << DpcColors::highlight("=== Available Firmware Versions ===") << std::endl;
                 auto releases = downloader.getAllReleases();
                 if (releases.empty()) {
-                    std::cerr << DpcColors::error("Failed to get available versions from GitHub") << std::endl;
+                    std::cerr << DpcColors::error("Failed to get available versions from " + downloader.getSourceName()) << std::endl;
                     std::exit(1);
                 }
                 
@@ -356,6 +544,110 @@ int main(int argc, char** argv) {
         }
     });
 
+    // Create a firmware delta (for publishing as release asset firmware-<base tag>.delta)
+    std::string delta_base = "";
+    std::string delta_target = "";
+    std::string delta_output = "";
+    auto create_delta_cmd = app.add_subcommand("create-delta", "Create a binary delta between two firmware images");
+    create_delta_cmd->add_option("--base", delta_base, "Firmware image the delta applies to")->required();
+    create_delta_cmd->add_option("--target", delta_target, "Firmware image the delta produces")->required();
+    create_delta_cmd->add_option("-o,--output", delta_output, "Delta file to write")->required();
+    create_delta_cmd->callback([&]() {
+        std::vector<uint8_t> base;
+        std::vector<uint8_t> target;
+        if (!DpcDelta::loadFile(delta_base, base) || !DpcDelta::loadFile(delta_target, target)) {
+            std::cerr << DpcColors::error("Cannot read firmware images") << std::endl;
+            std::exit(1);
+        }
+        
+        std::vector<uint8_t> patch = DpcDelta::create(base, target);
+        std::vector<uint8_t> check;
+        std::string error;
+        if (!DpcDelta::apply(base, patch, check, error) || !DpcDelta::saveFile(delta_output, patch)) {
+            std::cerr << DpcColors::error("Failed to create delta: " + (error.empty() ? delta_output : error)) << std::endl;
+            std::exit(1);
+        }
+        std::cout << DpcColors::ok("Delta written to " + delta_output + ": " + std::to_string(patch.size()) + " bytes for a " +
+                                   std::to_string(target.size()) + " byte image") << std::endl;
+    });
+
+    // Pack firmware versions and release information into one file for offline use
+    std::vector<std::string> bundle_versions;
+    std::string bundle_output = "";
+    bool bundle_offline = false;
+    std::string bundle_source = "";
+    auto create_bundle_cmd = app.add_subcommand("create-bundle", "Create an offline firmware bundle (use with --source on machines without network)");
+    create_bundle_cmd->add_flag("-v,--verbose", g_verbose, "Enable verbose mode");
+    create_bundle_cmd->add_option("--version", bundle_versions, "Version/tag to include, may be repeated (default: latest)");
+    create_bundle_cmd->add_option("-o,--output", bundle_output, "Bundle file to write")->required();
+    create_bundle_cmd->add_flag("--offline", bundle_offline, "Use only the local firmware cache, no network access");
+    create_bundle_cmd->add_option("--source", bundle_source, "Firmware source: github (default), a firmware bundle file, a mirror directory or file:// URL, or an http(s):// mirror URL");
+    create_bundle_cmd->callback([&]() {
+        try {
+            DpcDownload downloader(g_verbose);
+            downloader.setOffline(bundle_offline);
+            if (!downloader.setSource(bundle_source)) {
+                std::exit(1);
+            }
+            if (bundle_versions.empty()) {
+                bundle_versions.push_back("latest");
+            }
+            
+            std::string latest_tag = downloader.getLatestVersionTag();
+            std::vector<DpcBundle::Source> images;
+            for (const auto& version : bundle_versions) {
+                std::string tag = (version == "latest") ? latest_tag : version;
+                if (tag.empty()) {
+                    std::cerr << DpcColors::error("Failed to get latest version from " + downloader.getSourceName()) << std::endl;
+                    std::exit(1);
+                }
+                bool duplicate = std::any_of(images.begin(), images.end(),
+                                             [&](const DpcBundle::Source& image) { return image.tag == tag; });
+                if (duplicate) {
+                    continue;
+                }
+                std::string path = downloader.fetchFirmware(tag);
+                if (path.empty()) {
+                    std::cerr << DpcColors::error("Failed to get firmware " + tag) << std::endl;
+                    std::exit(1);
+                }
+                images.push_back({tag, path});
+            }
+            
+            std::string error;
+            if (!DpcBundle::create(bundle_output, images, latest_tag, downloader.getAllReleases().dump(), error)) {
+                std::cerr << DpcColors::error("Failed to create bundle: " + error) << std::endl;
+                std::exit(1);
+            }
+            std::cout << DpcColors::ok("Bundle written to " + bundle_output + " with " + std::to_string(images.size()) +
+                                       " firmware version(s)") << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << DpcColors::error("Error creating bundle: " + std::string(e.what())) << std::endl;
+            std::exit(1);
+        }
+    });
+
+    // Show the contents of a firmware bundle
+    std::string bundle_file = "";
+    auto list_bundle_cmd = app.add_subcommand("list-bundle", "List the firmware versions in an offline firmware bundle");
+    list_bundle_cmd->add_option("bundle", bundle_file, "Bundle file")->required();
+    list_bundle_cmd->callback([&]() {
+        DpcBundle bundle;
+        std::string error;
+        if (!bundle.open(bundle_file, error)) {
+            std::cerr << DpcColors::error("Cannot open bundle: " + error) << std::endl;
+            std::exit(1);
+        }
+        
+        std::cout << DpcColors::highlight("=== Firmware Bundle ===") << std::endl;
+        std::string latest_tag = bundle.getLatestTag();
+        for (const auto& image : bundle.list()) {
+            std::string version_display = image.tag + (image.tag == latest_tag ? " (latest)" : "");
+            std::cout << "  " << std::left << std::setw(21) << version_display
+                      << std::right << std::setw(9) << image.size << " bytes  sha256 " << image.sha256.substr(0, 12) << std::endl;
+        }
+    });
+
     CLI11_PARSE(app, argc, argv);
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,506 @@
+// diyPresso Device Simulator - Platform support: Linux and macOS (POSIX pseudo-terminal)
+#include "DpcSimulator.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+
+DpcSimulator::DpcSimulator(const Options& options)
+    : options_(options),
+      master_fd_(-1),
+      stop_requested_(false),
+      client_connected_(false),
+      telemetry_emitted_(0),
+      settings_(default_settings()),
+      rng_(options.seed),
+      flash_(FLASH_SIZE, 0xFF),
+      ram_(RAM_SIZE, 0),
+      copy_source_(0),
+      write_address_(0),
+      write_remaining_(0) {
+    registers_[NVMCTRL_INTFLAG] = 0x01;     // NVM controller always ready
+}
+
+DpcSimulator::~DpcSimulator() {
+    if (!link_path_.empty()) {
+        ::unlink(link_path_.c_str());
+    }
+    if (master_fd_ != -1) {
+        ::close(master_fd_);
+    }
+}
+
+bool DpcSimulator::open() {
+    master_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd_ == -1 || grantpt(master_fd_) != 0 || unlockpt(master_fd_) != 0) {
+        perror("Failed to create pseudo-terminal");
+        return false;
+    }
+
+    const char* name = ptsname(master_fd_);
+    if (!name) {
+        perror("Failed to get pseudo-terminal name");
+        return false;
+    }
+    port_ = name;
+
+    int flags = fcntl(master_fd_, F_GETFL);
+    fcntl(master_fd_, F_SETFL, flags | O_NONBLOCK);
+
+    // Open and close the slave once: from then on the master reports POLLHUP
+    // while no client has the port open, which is how connects are detected
+    int slave_fd = ::open(port_.c_str(), O_RDWR | O_NOCTTY);
+    if (slave_fd != -1) {
+        struct termios tty;
+        if (tcgetattr(slave_fd, &tty) == 0) {
+            cfmakeraw(&tty);
+            tcsetattr(slave_fd, TCSANOW, &tty);
+        }
+        ::close(slave_fd);
+    }
+
+    return true;
+}
+
+std::string DpcSimulator::get_port() const {
+    return port_;
+}
+
+bool DpcSimulator::create_link(const std::string& link_path) {
+    ::unlink(link_path.c_str());
+    if (::symlink(port_.c_str(), link_path.c_str()) != 0) {
+        perror("Failed to create port link");
+        return false;
+    }
+    link_path_ = link_path;
+    return true;
+}
+
+void DpcSimulator::run() {
+    while (!stop_requested_.load()) {
+        auto now = Clock::now();
+
+        // Sleep until the next scheduled line or telemetry tick, at most 100 ms
+        auto wake = now + std::chrono::milliseconds(100);
+        if (!pending_.empty()) {
+            wake = std::min(wake, pending_.front().due);
+        }
+        if (client_connected_ && options_.telemetry_rate > 0) {
+            auto next_tick = telemetry_start_ + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>((telemetry_emitted_ + 1) / options_.telemetry_rate));
+            wake = std::min(wake, next_tick);
+        }
+        int timeout_ms = static_cast<int>(std::max<long long>(0,
+            std::chrono::ceil<std::chrono::milliseconds>(wake - now).count()));
+
+        struct pollfd pfd;
+        pfd.fd = master_fd_;
+        pfd.events = POLLIN | (output_.empty() ? 0 : POLLOUT);
+        pfd.revents = 0;
+        int ready = ::poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        now = Clock::now();
+
+        // No client has the port open
+        if (ready > 0 && (pfd.revents & POLLHUP) && !(pfd.revents & POLLIN)) {
+            if (client_connected_) {
+                client_connected_ = false;
+                pending_.clear();
+                output_.clear();
+                input_.clear();
+                if (options_.verbose) {
+                    std::cout << "Client disconnected" << std::endl;
+                }
+            }
+            usleep(20000);
+            continue;
+        }
+
+        if (!client_connected_) {
+            on_connect(now);
+        }
+
+        // Commands from the client
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            char buffer[4096];
+            ssize_t count = ::read(master_fd_, buffer, sizeof(buffer));
+            if (count > 0 && options_.bootloader) {
+                input_.append(buffer, static_cast<size_t>(count));
+                handle_bootloader_input();
+            } else if (count > 0) {
+                input_.append(buffer, static_cast<size_t>(count));
+                size_t newline;
+                while ((newline = input_.find('\n')) != std::string::npos) {
+                    std::string command = input_.substr(0, newline);
+                    input_.erase(0, newline + 1);
+                    if (!command.empty() && command.back() == '\r') {
+                        command.pop_back();
+                    }
+                    if (!command.empty()) {
+                        handle_command(command, now);
+                    }
+                }
+            }
+        }
+
+        // Scheduled boot sequence and responses
+        while (!pending_.empty() && pending_.front().due <= now) {
+            emit(pending_.front().text);
+            pending_.pop_front();
+        }
+
+        emit_telemetry(now);
+        flush_output();
+    }
+}
+
+void DpcSimulator::stop() {
+    stop_requested_.store(true);
+}
+
+DpcSimulator::Stats DpcSimulator::get_stats() const {
+    return stats_;
+}
+
+void DpcSimulator::on_connect(Clock::time_point now) {
+    client_connected_ = true;
+    stats_.connections++;
+    if (options_.verbose) {
+        std::cout << "Client connected" << std::endl;
+    }
+
+    // The bootloader is silent until it receives commands
+    if (options_.bootloader) {
+        write_remaining_ = 0;
+        return;
+    }
+
+    // Boot sequence, ending where the telemetry stream starts
+    auto boot_time = now + std::chrono::milliseconds(options_.boot_delay_ms);
+    schedule("diyPresso One", boot_time);
+    schedule("Firmware version: " + options_.firmware_version, boot_time);
+    if (options_.legacy_firmware) {
+        // Pre-1.6.2 firmware prints its settings during boot
+        for (const auto& [key, value] : settings_) {
+            schedule(key + "=" + value, boot_time);
+        }
+    }
+    schedule("Boot complete", boot_time);
+
+    telemetry_start_ = boot_time;
+    telemetry_emitted_ = 0;
+}
+
+void DpcSimulator::handle_command(const std::string& command, Clock::time_point now) {
+    stats_.commands++;
+    if (options_.verbose) {
+        std::cout << "Command: " << command << std::endl;
+    }
+
+    // Pre-1.6.2 firmware has no command API
+    if (options_.legacy_firmware) {
+        return;
+    }
+
+    std::istringstream iss(command);
+    std::string verb, object;
+    iss >> verb >> object;
+    std::string prefix = verb + " " + object;
+    auto due = now + std::chrono::milliseconds(options_.response_latency_ms);
+
+    if (chance(options_.drop_probability)) {
+        return;
+    }
+    if (chance(options_.nok_probability)) {
+        schedule(prefix + " NOK", due);
+        return;
+    }
+
+    if (verb == "GET" && object == "info") {
+        schedule("firmwareVersion=" + options_.firmware_version, due);
+        schedule("hardware=simulator", due);
+        schedule(prefix + " OK", due);
+    } else if (verb == "GET" && object == "settings") {
+        for (const auto& [key, value] : settings_) {
+            schedule(key + "=" + value, due);
+        }
+        schedule(prefix + " OK", due);
+    } else if (verb == "PUT" && object == "settings") {
+        // PUT settings key=value,key=value,...
+        std::string payload;
+        std::getline(iss >> std::ws, payload);
+        std::map<std::string, std::string> updates;
+        bool valid = !payload.empty();
+        std::istringstream pairs(payload);
+        std::string pair;
+        while (valid && std::getline(pairs, pair, ',')) {
+            size_t equals = pair.find('=');
+            if (equals == std::string::npos || equals == 0 || !settings_.count(pair.substr(0, equals))) {
+                valid = false;
+                break;
+            }
+            updates[pair.substr(0, equals)] = pair.substr(equals + 1);
+        }
+        if (valid) {
+            for (const auto& [key, value] : updates) {
+                settings_[key] = value;
+            }
+            schedule(prefix + " OK", due);
+        } else {
+            schedule(prefix + " NOK", due);
+        }
+    } else {
+        schedule(prefix + " NOK", due);
+    }
+}
+
+void DpcSimulator::schedule(const std::string& text, Clock::time_point due) {
+    pending_.push_back(PendingLine{due, text});
+}
+
+void DpcSimulator::emit(std::string text) {
+    if (!text.empty() && chance(options_.garble_probability)) {
+        std::uniform_int_distribution<size_t> position(0, text.size() - 1);
+        text[position(rng_)] ^= 0x20;
+    }
+    text += "\r\n";
+    stats_.bytes_sent += text.size();
+    output_ += text;
+}
+
+void DpcSimulator::emit_telemetry(Clock::time_point now) {
+    if (!client_connected_ || options_.bootloader || options_.telemetry_rate <= 0 || now < telemetry_start_) {
+        return;
+    }
+
+    // Catch up with the configured rate, bounded so a slow client applies back-pressure
+    double elapsed = std::chrono::duration<double>(now - telemetry_start_).count();
+    uint64_t due = static_cast<uint64_t>(elapsed * options_.telemetry_rate);
+    while (telemetry_emitted_ < due && output_.size() < 65536) {
+        emit(telemetry_line());
+        telemetry_emitted_++;
+        stats_.telemetry_lines++;
+    }
+}
+
+void DpcSimulator::flush_output() {
+    while (!output_.empty()) {
+        ssize_t written = ::write(master_fd_, output_.data(), output_.size());
+        if (written <= 0) {
+            break; // pty buffer full (EAGAIN) or client gone; retried on POLLOUT
+        }
+        output_.erase(0, static_cast<size_t>(written));
+    }
+}
+
+bool DpcSimulator::chance(double probability) {
+    if (probability <= 0.0) return false;
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    return dist(rng_) < probability;
+}
+
+std::string DpcSimulator::telemetry_line() {
+    // Same shape as the controller's monitoring output
+    double phase = static_cast<double>(telemetry_emitted_ % 600) / 600.0 * 6.283185307179586;
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(2)
+       << "setpoint:98.00, power:" << 50.0 + 20.0 * std::sin(phase)
+       << ", average:" << 96.0 + std::sin(phase)
+       << ", act_temp:" << 97.5 + std::cos(phase)
+       << ", boiler-state:heating, boiler-error:OK, brew-state:idle"
+       << ", weight:-1160.40, end_weight:-1159.54, reservoir_level:77.3";
+    return ss.str();
+}
+
+std::map<std::string, std::string> DpcSimulator::default_settings() {
+    return {
+        {"commissioningDone", "1"},
+        {"crc", "2203501097"},
+        {"d", "70.00"},
+        {"extractionTime", "25.00"},
+        {"extractionWeight", "1.00"},
+        {"ff_brew", "35.00"},
+        {"ff_heat", "6.00"},
+        {"ff_ready", "6.00"},
+        {"i", "0.08"},
+        {"infusionTime", "1.00"},
+        {"p", "6.20"},
+        {"preInfusionTime", "3.00"},
+        {"shotCounter", "1"},
+        {"tareWeight", "-300.00"},
+        {"temperature", "22.00"},
+        {"trimWeight", "0.00"},
+        {"version", "1"},
+        {"wifiMode", "0"}
+    };
+}
+
+const std::vector<uint8_t>& DpcSimulator::get_flash() const {
+    return flash_;
+}
+
+void DpcSimulator::handle_bootloader_input() {
+    while (!input_.empty()) {
+        // Data of an "S" command
+        if (write_remaining_ > 0) {
+            size_t count = std::min(write_remaining_, input_.size());
+            if (uint8_t* dest = memory_at(write_address_, count)) {
+                std::copy(input_.begin(), input_.begin() + count, dest);
+            }
+            input_.erase(0, count);
+            write_address_ += static_cast<uint32_t>(count);
+            write_remaining_ -= count;
+            continue;
+        }
+
+        // Commands: letter, optional "<addr>[,<arg>]" in hex, terminated by '#'
+        size_t end = input_.find('#');
+        if (end == std::string::npos) {
+            return;
+        }
+        std::string command = input_.substr(0, end);
+        input_.erase(0, end + 1);
+        if (command.empty()) {
+            continue;
+        }
+
+        stats_.commands++;
+        if (options_.verbose) {
+            std::cout << "Bootloader command: " << command << std::endl;
+        }
+        uint32_t address = 0;
+        uint32_t argument = 0;
+        size_t comma = command.find(',');
+        try {
+            if (command.size() > 1) {
+                address = static_cast<uint32_t>(std::stoul(command.substr(1, comma == std::string::npos ? std::string::npos : comma - 1), nullptr, 16));
+            }
+            if (comma != std::string::npos) {
+                argument = static_cast<uint32_t>(std::stoul(command.substr(comma + 1), nullptr, 16));
+            }
+        } catch (const std::exception&) {
+            continue;   // Malformed numbers are ignored, like the real bootloader
+        }
+        handle_bootloader_command(command[0], address, argument);
+    }
+}
+
+void DpcSimulator::handle_bootloader_command(char command, uint32_t address, uint32_t argument) {
+    switch (command) {
+    case 'N':
+        reply("\n\r");
+        break;
+    case 'V':
+        reply(options_.bootloader_version + "\n\r");
+        break;
+    case 'S':
+        write_address_ = address;
+        write_remaining_ = argument;
+        break;
+    case 'R': {
+        const uint8_t* source = memory_at(address, argument);
+        reply(source ? std::string(reinterpret_cast<const char*>(source), argument) : std::string(argument, '\0'));
+        break;
+    }
+    case 'w': {
+        uint32_t value = 0;
+        if (const uint8_t* source = memory_at(address, 4)) {
+            value = source[0] | (source[1] << 8) | (source[2] << 16) | (static_cast<uint32_t>(source[3]) << 24);
+        } else {
+            value = registers_[address];
+        }
+        reply(std::string(reinterpret_cast<const char*>(&value), 4));
+        break;
+    }
+    case 'W':
+        if (address == 0xE000ED0C && argument == 0x05FA0004) {
+            stats_.resets++;
+            if (options_.verbose) {
+                std::cout << "Reset requested" << std::endl;
+            }
+        } else if (address == NVMCTRL_CTRLA && argument == 0xA502) {
+            // Erase row command; ADDR holds a 16-bit word address
+            uint32_t row = (registers_[NVMCTRL_ADDR] * 2) & ~(ROW_SIZE - 1);
+            if (row < FLASH_SIZE) {
+                std::fill(flash_.begin() + row, flash_.begin() + row + ROW_SIZE, 0xFF);
+                stats_.rows_erased++;
+            }
+        } else if (uint8_t* dest = memory_at(address, 4)) {
+            for (int i = 0; i < 4; ++i) dest[i] = static_cast<uint8_t>(argument >> (8 * i));
+        } else {
+            registers_[address] = argument;
+        }
+        break;
+    case 'X':
+        // Erase from address to the end of flash
+        if (address < FLASH_SIZE) {
+            std::fill(flash_.begin() + address, flash_.end(), 0xFF);
+            stats_.rows_erased += (FLASH_SIZE - address + ROW_SIZE - 1) / ROW_SIZE;
+        }
+        reply("X\n\r");
+        break;
+    case 'Y':
+        if (argument == 0) {
+            copy_source_ = address;
+        } else if (address + argument <= FLASH_SIZE) {
+            const uint8_t* source = memory_at(copy_source_, argument);
+            if (source) {
+                // Programming can only clear bits: unerased flash keeps stale zeros
+                for (uint32_t i = 0; i < argument; ++i) {
+                    flash_[address + i] &= source[i];
+                }
+                stats_.flash_bytes_written += argument;
+            }
+            if (options_.flash_page_us > 0) {
+                usleep(static_cast<useconds_t>(options_.flash_page_us) * ((argument + 63) / 64));
+            }
+        }
+        reply("Y\n\r");
+        break;
+    case 'Z': {
+        const uint8_t* source = memory_at(address, argument);
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "Z%08X#", source ? crc16(source, argument) : 0);
+        reply(std::string(buffer) + "\n\r");
+        break;
+    }
+    default:
+        break;  // T (terminal mode), G (go) and unknown commands have no reply in binary mode
+    }
+}
+
+uint8_t* DpcSimulator::memory_at(uint32_t address, size_t size) {
+    if (address + size <= FLASH_SIZE) {
+        return flash_.data() + address;
+    }
+    if (address >= RAM_START && address - RAM_START + size <= RAM_SIZE) {
+        return ram_.data() + (address - RAM_START);
+    }
+    return nullptr;
+}
+
+void DpcSimulator::reply(const std::string& data) {
+    stats_.bytes_sent += data.size();
+    output_ += data;
+}
+
+uint16_t DpcSimulator::crc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,121 @@
+// diyPresso Device Simulator - Platform support: Linux and macOS (POSIX pseudo-terminal)
+#pragma once
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <random>
+#include <atomic>
+#include <chrono>
+
+// Emulates the serial side of a diyPresso controller on a pseudo-terminal, so the client's
+// DpcSerial/DpcDevice/DpcSettings code paths can run without an Arduino MKR WiFi 1010.
+// In bootloader mode it emulates the SAM-BA bootloader instead, for DpcSamba/DpcFlasher.
+class DpcSimulator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::string firmware_version = "1.7.0";
+        bool legacy_firmware = false;       // pre-1.6.2: settings only in the boot sequence, no API
+        int boot_delay_ms = 300;            // Delay between a client opening the port and the boot sequence
+        int response_latency_ms = 0;        // Delay before each command response
+        double telemetry_rate = 1.0;        // setpoint: lines per second (0 = off)
+        double drop_probability = 0.0;      // Fault: command is never answered
+        double nok_probability = 0.0;       // Fault: command is answered with NOK
+        double garble_probability = 0.0;    // Fault: an output line gets a corrupted byte
+        unsigned int seed = 1;
+        bool verbose = false;
+
+        // SAM-BA bootloader mode (binary protocol of the Arduino SAMD21 bootloader)
+        bool bootloader = false;
+        std::string bootloader_version = "v2.0 [Arduino:XYZ] Apr 19 2019 14:38:48";
+        int flash_page_us = 0;              // Simulated programming time per 64-byte page
+    };
+
+    struct Stats {
+        uint64_t connections = 0;
+        uint64_t commands = 0;
+        uint64_t telemetry_lines = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t flash_bytes_written = 0;   // Bootloader mode
+        uint64_t rows_erased = 0;           // Bootloader mode
+        uint64_t resets = 0;                // Bootloader mode: AIRCR reset requests
+    };
+
+    // Bootloader mode memory, for checking what a flasher wrote
+    const std::vector<uint8_t>& get_flash() const;
+
+    explicit DpcSimulator(const Options& options);
+    ~DpcSimulator();
+
+    // Delete copy constructor and assignment operator
+    DpcSimulator(const DpcSimulator&) = delete;
+    DpcSimulator& operator=(const DpcSimulator&) = delete;
+
+    // Create the pseudo-terminal; get_port() is the path clients open
+    bool open();
+    std::string get_port() const;
+    bool create_link(const std::string& link_path);
+
+    // Serve until stop() is called (safe from a signal handler or another thread)
+    void run();
+    void stop();
+
+    Stats get_stats() const;
+
+private:
+    struct PendingLine {
+        Clock::time_point due;
+        std::string text;
+    };
+
+    Options options_;
+    int master_fd_;
+    std::string port_;
+    std::string link_path_;
+    std::atomic<bool> stop_requested_;
+    Stats stats_;
+
+    bool client_connected_;
+    Clock::time_point telemetry_start_;
+    uint64_t telemetry_emitted_;
+    std::string input_;                 // Partial command line from the client
+    std::string output_;                // Bytes not yet accepted by the pty
+    std::deque<PendingLine> pending_;   // Scheduled boot/response lines
+    std::map<std::string, std::string> settings_;
+    std::mt19937 rng_;
+
+    // Bootloader mode state
+    std::vector<uint8_t> flash_;
+    std::vector<uint8_t> ram_;
+    std::map<uint32_t, uint32_t> registers_;
+    uint32_t copy_source_;              // RAM address set by "Y<addr>,0#"
+    uint32_t write_address_;            // Target of the "S" data still expected
+    size_t write_remaining_;
+
+    void on_connect(Clock::time_point now);
+    void handle_command(const std::string& command, Clock::time_point now);
+    void schedule(const std::string& text, Clock::time_point due);
+    void emit(std::string text);
+    void emit_telemetry(Clock::time_point now);
+    void flush_output();
+    bool chance(double probability);
+    std::string telemetry_line();
+    static std::map<std::string, std::string> default_settings();
+
+    void handle_bootloader_input();
+    void handle_bootloader_command(char command, uint32_t address, uint32_t argument);
+    uint8_t* memory_at(uint32_t address, size_t size);
+    void reply(const std::string& data);
+    static uint16_t crc16(const uint8_t* data, size_t size);
+
+    static constexpr uint32_t FLASH_SIZE = 0x40000;
+    static constexpr uint32_t RAM_START = 0x20000000;
+    static constexpr uint32_t RAM_SIZE = 0x8000;
+    static constexpr uint32_t ROW_SIZE = 256;
+    static constexpr uint32_t NVMCTRL_CTRLA = 0x41004000;
+    static constexpr uint32_t NVMCTRL_INTFLAG = 0x41004014;
+    static constexpr uint32_t NVMCTRL_ADDR = 0x4100401C;
+};
@@ -0,0 +1,278 @@
+// diyPresso Serial Benchmark - Platform support: Linux and macOS (POSIX pseudo-terminal)
+//
+// Drives DpcSerial::readline, DpcDevice::send_command and DpcSettings::get_settings
+// against a simulated device (DpcSimulator in a forked child process) and prints
+// machine-readable JSON, so runs can be compared over time.
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/utsname.h>
+#include <CLI/CLI.hpp>
+#include <nlohmann/json.hpp>
+#include "DpcSimulator.h"
+#include "DpcSerial.h"
+#include "DpcDevice.h"
+#include "DpcSettings.h"
+
+// Allocation counting: every operator new in this process bumps the counter
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double cpu_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+double elapsed_seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Simulated device served by a child process, so its CPU time and allocations
+// are not attributed to the client code being measured
+class SimulatorProcess {
+public:
+    explicit SimulatorProcess(const DpcSimulator::Options& options) : pid_(-1) {
+        DpcSimulator simulator(options);
+        if (!simulator.open()) {
+            return;
+        }
+        port_ = simulator.get_port();
+
+        pid_ = fork();
+        if (pid_ == 0) {
+            simulator.run();
+            _exit(0);
+        }
+    }
+
+    ~SimulatorProcess() {
+        if (pid_ > 0) {
+            kill(pid_, SIGKILL);
+            waitpid(pid_, nullptr, 0);
+        }
+    }
+
+    bool ok() const { return pid_ > 0; }
+    const std::string& port() const { return port_; }
+
+private:
+    pid_t pid_;
+    std::string port_;
+};
+
+nlohmann::json latency_summary(std::vector<double> samples_ms) {
+    if (samples_ms.empty()) {
+        return nlohmann::json::object();
+    }
+    std::sort(samples_ms.begin(), samples_ms.end());
+    auto percentile = [&](double p) {
+        size_t index = static_cast<size_t>(std::ceil(p * samples_ms.size()));
+        return samples_ms[std::min(samples_ms.size() - 1, index > 0 ? index - 1 : 0)];
+    };
+    double sum = 0;
+    for (double sample : samples_ms) sum += sample;
+    return nlohmann::json{
+        {"samples", samples_ms.size()},
+        {"p50_ms", percentile(0.50)},
+        {"p99_ms", percentile(0.99)},
+        {"mean_ms", sum / samples_ms.size()},
+        {"min_ms", samples_ms.front()},
+        {"max_ms", samples_ms.back()}
+    };
+}
+
+// Raw line throughput of DpcSerial::readline against a flooding device
+nlohmann::json bench_readline(size_t line_count, bool threaded) {
+    DpcSimulator::Options options;
+    options.boot_delay_ms = 50;
+    options.telemetry_rate = 1e9;   // As fast as the pty accepts
+
+    SimulatorProcess simulator(options);
+    DpcSerial serial;
+    if (!simulator.ok() || !serial.open(simulator.port())) {
+        return {{"error", "failed to start simulator"}};
+    }
+    if (threaded) {
+        serial.start_reader();
+    }
+
+    std::string_view line;
+    auto deadline = [] { return Clock::now() + std::chrono::seconds(5); };
+
+    // Warm-up: wait for the telemetry stream and let buffers reach steady state
+    for (int i = 0; i < 1000; ++i) {
+        if (serial.readline(line, deadline()) != DpcSerial::ReadStatus::Ok) {
+            return {{"error", "no telemetry from simulator"}};
+        }
+    }
+
+    uint64_t bytes = 0;
+    size_t lines = 0;
+    uint64_t allocations_before = g_allocations.load();
+    double cpu_before = cpu_seconds();
+    auto start = Clock::now();
+
+    while (lines < line_count && serial.readline(line, deadline()) == DpcSerial::ReadStatus::Ok) {
+        bytes += line.size();
+        lines++;
+    }
+
+    double wall = elapsed_seconds(start);
+    double cpu = cpu_seconds() - cpu_before;
+    uint64_t allocations = g_allocations.load() - allocations_before;
+    size_t dropped = serial.get_dropped_lines();
+    serial.close();
+
+    return nlohmann::json{
+        {"lines", lines},
+        {"bytes", bytes},
+        {"seconds", wall},
+        {"lines_per_sec", lines / wall},
+        {"bytes_per_sec", bytes / wall},
+        {"cpu_us_per_line", lines ? cpu * 1e6 / lines : 0.0},
+        {"allocs_per_line", lines ? static_cast<double>(allocations) / lines : 0.0},
+        {"dropped_lines", dropped}
+    };
+}
+
+// Command round trips through DpcDevice::send_command or DpcSettings::get_settings
+template <typename Operation>
+nlohmann::json bench_round_trips(size_t iterations, int latency_ms, double telemetry_rate, Operation operation) {
+    DpcSimulator::Options options;
+    options.boot_delay_ms = 50;
+    options.response_latency_ms = latency_ms;
+    options.telemetry_rate = telemetry_rate;
+
+    SimulatorProcess simulator(options);
+    DpcDevice device;
+    if (!simulator.ok() || !device.connect(simulator.port())) {
+        return {{"error", "failed to connect to simulator"}};
+    }
+
+    std::vector<double> samples_ms;
+    samples_ms.reserve(iterations);
+    size_t failures = 0;
+
+    uint64_t allocations_before = g_allocations.load();
+    double cpu_before = cpu_seconds();
+    auto start = Clock::now();
+
+    for (size_t i = 0; i < iterations; ++i) {
+        auto call_start = Clock::now();
+        try {
+            operation(device);
+            samples_ms.push_back(elapsed_seconds(call_start) * 1000.0);
+        } catch (const std::exception&) {
+            failures++;
+        }
+    }
+
+    double wall = elapsed_seconds(start);
+    double cpu = cpu_seconds() - cpu_before;
+    uint64_t allocations = g_allocations.load() - allocations_before;
+    device.disconnect();
+
+    nlohmann::json result = latency_summary(samples_ms);
+    result["iterations"] = iterations;
+    result["failures"] = failures;
+    result["seconds"] = wall;
+    result["cpu_us_per_call"] = iterations ? cpu * 1e6 / iterations : 0.0;
+    result["allocs_per_call"] = iterations ? static_cast<double>(allocations) / iterations : 0.0;
+    return result;
+}
+
+std::string host_name() {
+    struct utsname info;
+    if (uname(&info) != 0) return "unknown";
+    return std::string(info.nodename) + " (" + info.sysname + " " + info.release + " " + info.machine + ")";
+}
+
+std::string utc_timestamp() {
+    std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t line_count = 200000;
+    size_t iterations = 500;
+    int latency_ms = 0;
+    double telemetry_rate = 10.0;
+    std::string output_path = "";
+
+    CLI::App app{"diyPresso serial throughput and latency benchmark"};
+    app.add_option("--lines", line_count, "Lines to read in the readline benchmarks");
+    app.add_option("--iterations", iterations, "Round trips in the command benchmarks");
+    app.add_option("--latency-ms", latency_ms, "Simulated device response latency");
+    app.add_option("--telemetry-rate", telemetry_rate, "setpoint: lines per second during command benchmarks");
+    app.add_option("-o,--output", output_path, "Write JSON results to this file instead of stdout");
+
+    CLI11_PARSE(app, argc, argv);
+
+    nlohmann::json report;
+    report["benchmark"] = "diypresso-serial";
+    report["timestamp"] = utc_timestamp();
+    report["host"] = host_name();
+    report["parameters"] = {
+        {"lines", line_count},
+        {"iterations", iterations},
+        {"latency_ms", latency_ms},
+        {"telemetry_rate", telemetry_rate}
+    };
+
+    report["results"]["readline"] = bench_readline(line_count, false);
+    report["results"]["readline_threaded"] = bench_readline(line_count, true);
+    report["results"]["send_command"] = bench_round_trips(iterations, latency_ms, telemetry_rate,
+        [](DpcDevice& device) { device.send_command("GET info", 5); });
+    report["results"]["get_settings"] = bench_round_trips(iterations, latency_ms, telemetry_rate,
+        [](DpcDevice& device) {
+            DpcSettings settings;
+            settings.get_settings(device);
+        });
+
+    if (output_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream file(output_path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not create file: " << output_path << std::endl;
+            return 1;
+        }
+        file << report.dump(2) << std::endl;
+        std::cerr << "Benchmark results written to: " << output_path << std::endl;
+    }
+    return 0;
+}
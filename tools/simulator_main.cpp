@@ -0,0 +1,64 @@
+// diyPresso Device Simulator - Platform support: Linux and macOS (POSIX pseudo-terminal)
+#include <iostream>
+#include <csignal>
+#include <CLI/CLI.hpp>
+#include "DpcSimulator.h"
+
+DpcSimulator* g_simulator = nullptr;
+
+void signal_handler(int /* signal */) {
+    if (g_simulator) {
+        g_simulator->stop();
+    }
+}
+
+int main(int argc, char** argv) {
+    DpcSimulator::Options options;
+    std::string link_path = "";
+
+    CLI::App app{"diyPresso device simulator (pseudo-terminal)"};
+    app.add_option("--link", link_path, "Create a symlink to the simulated port at this path");
+    app.add_option("--firmware-version", options.firmware_version, "Firmware version reported by GET info");
+    app.add_flag("--legacy", options.legacy_firmware, "Simulate pre-1.6.2 firmware (settings in boot sequence, no API)");
+    app.add_option("--boot-delay-ms", options.boot_delay_ms, "Delay before the boot sequence after a client connects");
+    app.add_option("--latency-ms", options.response_latency_ms, "Delay before each command response");
+    app.add_option("--telemetry-rate", options.telemetry_rate, "setpoint: lines per second (0 = off)");
+    app.add_option("--drop", options.drop_probability, "Probability that a command is never answered");
+    app.add_option("--nok", options.nok_probability, "Probability that a command is answered with NOK");
+    app.add_option("--garble", options.garble_probability, "Probability that an output line is corrupted");
+    app.add_option("--seed", options.seed, "Random seed for fault injection");
+    app.add_flag("--bootloader", options.bootloader, "Simulate the SAM-BA bootloader instead of the application");
+    app.add_option("--flash-page-us", options.flash_page_us, "Bootloader mode: programming time per 64-byte page");
+    app.add_flag("-v,--verbose", options.verbose, "Log connections and commands");
+
+    CLI11_PARSE(app, argc, argv);
+
+    DpcSimulator simulator(options);
+    if (!simulator.open()) {
+        return 1;
+    }
+    if (!link_path.empty() && !simulator.create_link(link_path)) {
+        return 1;
+    }
+
+    g_simulator = &simulator;
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    std::cout << "Simulated diyPresso on port: " << simulator.get_port() << std::endl;
+    if (!link_path.empty()) {
+        std::cout << "Linked as: " << link_path << std::endl;
+    }
+    std::cout << "Press Ctrl+C to exit." << std::endl;
+
+    simulator.run();
+
+    auto stats = simulator.get_stats();
+    std::cout << "Connections: " << stats.connections << ", commands: " << stats.commands
+              << ", telemetry lines: " << stats.telemetry_lines << ", bytes sent: " << stats.bytes_sent << std::endl;
+    if (options.bootloader) {
+        std::cout << "Flash bytes written: " << stats.flash_bytes_written << ", rows erased: " << stats.rows_erased
+                  << ", resets: " << stats.resets << std::endl;
+    }
+    return 0;
+}
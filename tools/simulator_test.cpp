@@ -0,0 +1,164 @@
+// diyPresso Protocol Test - Platform support: Linux and macOS (POSIX pseudo-terminal)
+//
+// Runs DpcDevice and DpcSettings against the diypresso-simulator executable (started
+// as a child process on a symlinked pty), so the command protocol can be regression
+// tested on CI without hardware. Usage: diypresso-simulator-test <simulator binary>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "DpcDevice.h"
+#include "DpcSettings.h"
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    std::cout << (condition ? "PASS: " : "FAIL: ") << what << std::endl;
+    if (!condition) {
+        g_failures++;
+    }
+}
+
+// diypresso-simulator serving a pty linked at a temporary path, stopped on destruction
+class Simulator {
+public:
+    Simulator(const std::string& binary, const std::vector<std::string>& options) : pid_(-1) {
+        char directory[] = "/tmp/diypresso-test-XXXXXX";
+        if (!mkdtemp(directory)) {
+            return;
+        }
+        directory_ = directory;
+        link_ = directory_ + "/port";
+
+        std::vector<std::string> arguments = {binary, "--link", link_, "--boot-delay-ms", "50", "--telemetry-rate", "20"};
+        arguments.insert(arguments.end(), options.begin(), options.end());
+        pid_ = fork();
+        if (pid_ == 0) {
+            // Keep the test output readable: the simulator's banner goes nowhere
+            int null = ::open("/dev/null", O_WRONLY);
+            if (null >= 0) {
+                dup2(null, STDOUT_FILENO);
+            }
+            std::vector<char*> argv;
+            for (auto& argument : arguments) {
+                argv.push_back(const_cast<char*>(argument.c_str()));
+            }
+            argv.push_back(nullptr);
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+
+        // The link appears once the pty is ready
+        auto deadline = std::chrono::steady_clock::now() + STARTUP_TIMEOUT;
+        while (pid_ > 0 && access(link_.c_str(), F_OK) != 0) {
+            if (std::chrono::steady_clock::now() >= deadline || waitpid(pid_, nullptr, WNOHANG) == pid_) {
+                stop();
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    ~Simulator() {
+        stop();
+        if (!link_.empty()) {
+            unlink(link_.c_str());
+        }
+        if (!directory_.empty()) {
+            rmdir(directory_.c_str());
+        }
+    }
+
+    bool ok() const { return pid_ > 0; }
+    const std::string& port() const { return link_; }
+
+private:
+    pid_t pid_;
+    std::string directory_;
+    std::string link_;
+
+    static constexpr std::chrono::seconds STARTUP_TIMEOUT{5};
+
+    void stop() {
+        if (pid_ > 0) {
+            kill(pid_, SIGTERM);
+            waitpid(pid_, nullptr, 0);
+            pid_ = -1;
+        }
+    }
+};
+
+// Expect send_command to throw with a message containing 'expected'
+void check_command_fails(DpcDevice& device, const std::string& command, int timeout_seconds,
+                         const std::string& expected, const std::string& what) {
+    try {
+        device.send_command(command, timeout_seconds);
+        check(false, what + " (command succeeded)");
+    } catch (const std::exception& e) {
+        check(std::string(e.what()).find(expected) != std::string::npos, what + " (" + e.what() + ")");
+    }
+}
+
+void test_commands(const std::string& binary) {
+    Simulator simulator(binary, {"--firmware-version", "1.7.0"});
+    check(simulator.ok(), "simulator started");
+    if (!simulator.ok()) {
+        return;
+    }
+
+    DpcDevice device;
+    check(device.connect(simulator.port()), "connect to simulated port");
+    check(device.get_device_info().firmware_version == "1.7.0", "GET info reports the firmware version");
+
+    DpcSettings settings;
+    DpcSettings::Settings current = settings.get_settings(device);
+    check(current.size() == 18 && current["p"] == "6.20", "GET settings returns all settings");
+
+    DpcSettings::Settings changed = current;
+    changed["p"] = "7.50";
+    check(settings.put_settings(device, changed), "PUT settings accepted");
+    check(settings.get_settings(device)["p"] == "7.50", "PUT settings value read back");
+
+    check_command_fails(device, "GET unknown", 2, "Command failed", "unknown command answered with NOK");
+    device.disconnect();
+}
+
+void test_faults(const std::string& binary) {
+    {
+        Simulator simulator(binary, {"--nok", "1"});
+        DpcDevice device;
+        check(simulator.ok() && device.connect(simulator.port()), "connect with NOK fault injection");
+        check_command_fails(device, "GET info", 2, "Command failed", "injected NOK raises an error");
+    }
+    {
+        Simulator simulator(binary, {"--drop", "1"});
+        DpcDevice device;
+        check(simulator.ok() && device.connect(simulator.port()), "connect with dropped responses");
+        check_command_fails(device, "GET settings", 1, "Timeout", "dropped response times out");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <diypresso-simulator binary>" << std::endl;
+        return 2;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    test_commands(argv[1]);
+    test_faults(argv[1]);
+
+    std::cout << (g_failures == 0 ? "All protocol tests passed" : std::to_string(g_failures) + " check(s) failed")
+              << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}